@@ -0,0 +1,341 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <new>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+#include "bench.hpp"
+#include "input.hpp"
+#include "solver.hpp"
+#include "common/vec2.hpp"
+
+namespace
+{
+  // Set by bench_task() only around its timed runs, all threads count while it is set.
+  std::atomic<bool> counting_allocations{ false };
+  std::atomic<uint64_t> num_allocations{ 0 };
+  std::atomic<uint64_t> num_allocated_bytes{ 0 };
+}
+
+// Kept out of line: inlined into callers, GCC pairs the malloc() and free() inside them with
+// new and delete expressions and warns (-Wmismatched-new-delete).
+#if defined(__GNUC__)
+#define BENCH_NOINLINE __attribute__((noinline))
+#else
+#define BENCH_NOINLINE
+#endif
+
+// Global allocation functions, replaced to count allocations for the benchmarks.
+// Outside of them this is a plain malloc() behind one relaxed load.
+// The array and nothrow forms forward to these.
+BENCH_NOINLINE void* operator new(size_t size)
+{
+  if (counting_allocations.load(std::memory_order_relaxed))
+  {
+    num_allocations.fetch_add(1, std::memory_order_relaxed);
+    num_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+  }
+  void* p = malloc(size == 0 ? 1 : size);
+  if (p == nullptr)
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+BENCH_NOINLINE void operator delete(void* p) noexcept
+{
+  free(p);
+}
+
+BENCH_NOINLINE void operator delete(void* p, size_t) noexcept
+{
+  free(p);
+}
+
+namespace
+{
+  using bench_clock = std::chrono::steady_clock;
+
+  const int warmup_runs = 1;
+  const int min_runs = 5;
+  const int max_runs = 100;
+  // Tasks stop repeating after this much time, once they have min_runs.
+  const double time_budget_ms = 2000.0;
+
+  double elapsed_ms(bench_clock::time_point start)
+  {
+    return std::chrono::duration<double, std::milli>(bench_clock::now() - start).count();
+  }
+
+  // Nearest-rank percentile of sorted samples.
+  double percentile(std::vector<double> const& sorted, double p)
+  {
+    const size_t rank = (size_t)std::ceil(p * sorted.size());
+    return sorted[std::max<size_t>(rank, 1) - 1];
+  }
+
+  void reset_peak_rss()
+  {
+#if defined(__linux__)
+    // Resets VmHWM to the current RSS (Linux 4.0+), silently does nothing where not permitted.
+    file_ptr clear_refs{ fopen("/proc/self/clear_refs", "w") };
+    if (clear_refs)
+    {
+      fputs("5", clear_refs.get());
+    }
+#endif
+  }
+
+  unsigned long long peak_rss_kb()
+  {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+      return counters.PeakWorkingSetSize / 1024;
+    }
+    return 0;
+#elif defined(__linux__)
+    file_ptr status{ fopen("/proc/self/status", "r") };
+    char line[256];
+    while (status && fgets(line, sizeof(line), status.get()))
+    {
+      unsigned long long kb = 0;
+      if (sscanf(line, "VmHWM: %llu", &kb) == 1)
+      {
+        return kb;
+      }
+    }
+    return 0;
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    // Bytes on macOS.
+    return (unsigned long long)usage.ru_maxrss / 1024;
+#endif
+  }
+
+  bool bench_task(solver_info const& solver)
+  {
+    const bench_clock::time_point load_start = bench_clock::now();
+    input_text input_buffer = read_input(solver.day);
+    const double load_ms = elapsed_ms(load_start);
+    if (!input_buffer)
+    {
+      return false;
+    }
+
+    std::vector<double> times;
+    times.reserve(max_runs);
+
+    char parse_ms[32] = "-";
+    if (solver.parse != nullptr)
+    {
+      for (int i = 0; i < max_runs; i++)
+      {
+        const bench_clock::time_point start = bench_clock::now();
+        solver.parse(input_buffer.get());
+        times.push_back(elapsed_ms(start));
+      }
+      std::sort(times.begin(), times.end());
+      sprintf(parse_ms, "%.3f", percentile(times, 0.5));
+      times.clear();
+    }
+
+    reset_peak_rss();
+    for (int i = 0; i < warmup_runs; i++)
+    {
+      output_sink output;
+      solver.solve(input_buffer.get(), output);
+    }
+
+    const uint64_t allocations_before = num_allocations.load(std::memory_order_relaxed);
+    const uint64_t bytes_before = num_allocated_bytes.load(std::memory_order_relaxed);
+    counting_allocations.store(true, std::memory_order_relaxed);
+    const bench_clock::time_point bench_start = bench_clock::now();
+    while ((int)times.size() < max_runs && ((int)times.size() < min_runs || elapsed_ms(bench_start) < time_budget_ms))
+    {
+      // Discards the text, so the timings include formatting but no I/O.
+      output_sink output;
+      const bench_clock::time_point start = bench_clock::now();
+      solver.solve(input_buffer.get(), output);
+      times.push_back(elapsed_ms(start));
+    }
+    counting_allocations.store(false, std::memory_order_relaxed);
+    const uint64_t runs = times.size();
+    const uint64_t allocations = (num_allocations.load(std::memory_order_relaxed) - allocations_before) / runs;
+    const uint64_t bytes = (num_allocated_bytes.load(std::memory_order_relaxed) - bytes_before) / runs;
+
+    std::sort(times.begin(), times.end());
+    printf("%d\t%d\t%llu\t%.3f\t%s\t%.3f\t%.3f\t%.3f\t%llu\t%llu\t%llu\n",
+      solver.day, solver.subtask, runs, load_ms, parse_ms,
+      times.front(), percentile(times, 0.5), percentile(times, 0.99),
+      allocations, bytes, peak_rss_kb());
+    fflush(stdout);
+    return true;
+  }
+}
+
+int run_benchmarks(int day, int subtask)
+{
+  printf("day\tpart\truns\tload_ms\tparse_ms\tmin_ms\tmedian_ms\tp99_ms\tallocs\talloc_bytes\tpeak_rss_kb\n");
+  int num_tasks = 0;
+  for (solver_info const& solver : all_solvers())
+  {
+    if ((day == 0 || solver.day == day) && (subtask == 0 || solver.subtask == subtask) && !solver.interactive && bench_task(solver))
+    {
+      num_tasks++;
+    }
+  }
+  return num_tasks > 0 ? 0 : 1;
+}
+
+namespace
+{
+  // What vec2_hasher used to be.
+  struct coordinate_sum_hasher
+  {
+    uint64_t operator()(vec2 v) const
+    {
+      return v.x + v.y;
+    }
+  };
+
+  // Position on a level of a recursive maze, as in day 20.
+  struct level_point
+  {
+    vec2 position;
+    int level;
+  };
+
+  bool operator==(level_point const& l, level_point const& r)
+  {
+    return l.position == r.position && l.level == r.level;
+  }
+
+  // What day 20's multilevel_point_hasher used to be: the level was ignored.
+  struct position_sum_hasher
+  {
+    uint64_t operator()(level_point const& p) const
+    {
+      return coordinate_sum_hasher{}(p.position);
+    }
+  };
+
+  struct level_point_hasher
+  {
+    uint64_t operator()(level_point const& p) const
+    {
+      return hash_combine(vec2_hasher{}(p.position), (uint64_t)p.level);
+    }
+  };
+
+  template <class hasher, class key_type>
+  void bench_hash(const char* keys_name, const char* hasher_name, std::vector<key_type> const& keys)
+  {
+    std::unordered_set<key_type, hasher> set(keys.begin(), keys.end());
+    size_t max_bucket = 0;
+    uint64_t probes = 0;
+    for (size_t b = 0; b < set.bucket_count(); b++)
+    {
+      const size_t n = set.bucket_size(b);
+      max_bucket = std::max(max_bucket, n);
+      probes += n * n;
+    }
+
+    std::unordered_map<key_type, int, hasher> map;
+    for (key_type const& key : keys)
+    {
+      map[key] = 1;
+    }
+    // Repeats the lookups for at least a million finds.
+    const size_t rounds = std::max<size_t>(1, 1000000 / keys.size());
+    int64_t found = 0;
+    const bench_clock::time_point start = bench_clock::now();
+    for (size_t r = 0; r < rounds; r++)
+    {
+      for (key_type const& key : keys)
+      {
+        found += map.find(key)->second;
+      }
+    }
+    const double ns = elapsed_ms(start) * 1e6 / (double)found;
+
+    printf("%s\t%s\t%zu\t%zu\t%zu\t%.2f\t%.1f\n",
+      keys_name, hasher_name, set.size(), set.bucket_count(), max_bucket, (double)probes / set.size(), ns);
+    fflush(stdout);
+  }
+
+  void bench_hashers(const char* keys_name, std::vector<vec2> const& keys)
+  {
+    bench_hash<coordinate_sum_hasher>(keys_name, "sum", keys);
+    bench_hash<vec2_hasher>(keys_name, "vec2_hasher", keys);
+  }
+
+  void bench_hashers(const char* keys_name, std::vector<level_point> const& keys)
+  {
+    bench_hash<position_sum_hasher>(keys_name, "sum", keys);
+    bench_hash<level_point_hasher>(keys_name, "multilevel", keys);
+  }
+}
+
+int run_hash_benchmark()
+{
+  printf("keys\thasher\tcount\tbuckets\tmax_bucket\tmean_probe\tlookup_ns\n");
+
+  std::vector<vec2> keys;
+  for (int y = 0; y < 256; y++)
+  {
+    for (int x = 0; x < 256; x++)
+    {
+      keys.push_back({ x, y });
+    }
+  }
+  bench_hashers("grid", keys);
+
+  keys.clear();
+  std::mt19937 rng(2019);
+  std::unordered_set<vec2, vec2_hasher> visited;
+  vec2 p = { 0, 0 };
+  for (int step = 0; step < 200000; step++)
+  {
+    const int d = (int)(rng() % 4);
+    p = p + vec2{ d == 0 ? 1 : d == 1 ? -1 : 0, d == 2 ? 1 : d == 3 ? -1 : 0 };
+    if (visited.insert(p).second)
+    {
+      keys.push_back(p);
+    }
+  }
+  bench_hashers("walk", keys);
+
+  std::vector<level_point> level_keys;
+  for (int level = 0; level < 64; level++)
+  {
+    for (int y = 0; y < 32; y++)
+    {
+      for (int x = 0; x < 32; x++)
+      {
+        level_keys.push_back({ { x, y }, level });
+      }
+    }
+  }
+  bench_hashers("levels", level_keys);
+  return 0;
+}
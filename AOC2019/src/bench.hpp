@@ -0,0 +1,28 @@
+#pragma once
+
+// Times every non-interactive solver that has an input file (or only 'day', and only 'subtask', when nonzero)
+// and prints one tab-separated row per task to stdout:
+//
+//   day part runs load_ms parse_ms min_ms median_ms p99_ms allocs alloc_bytes peak_rss_kb
+//
+// Each task gets warm-up runs first, then repeated timed runs of solve() on the same input.
+// min/median/p99 are solve() times, which include parsing or loading the parse cache (see
+// parse_cache.hpp, PARSE_CACHE=0 times the parsers). parse_ms is the median time of the day's
+// parser alone (solver_info::parse), "-" for days whose parse isn't separate from the solve.
+// allocs and alloc_bytes are per solve() call. peak_rss_kb is the task's peak resident set size
+// where the OS can reset it between tasks (Linux), and the process peak so far elsewhere.
+// Allocations are counted by replacing the global operator new and delete (bench.cpp), for the
+// whole program, but they only count during the timed runs.
+// Returns 0 if at least one task was run.
+int run_benchmarks(int day, int subtask);
+
+// Compares the old coordinate-sum hashes with vec2_hasher and day 20's multilevel hash on key
+// sets like the solvers' (a dense grid, a robot's random walk, points on recursive maze levels)
+// and prints one row per key set and hasher:
+//
+//   keys hasher count buckets max_bucket mean_probe lookup_ns
+//
+// max_bucket is the most keys sharing a bucket of a std::unordered_set, mean_probe the mean
+// number of keys in the bucket of a key (1.0 with no collisions), lookup_ns the mean time of
+// a successful find() in an std::unordered_map.
+int run_hash_benchmark();
@@ -1,7 +1,12 @@
 #pragma once
+#include <cassert>
+#include <cstdint>
+#include <limits>
 #include <vector>
 #include <unordered_map>
-#include <queue>
+
+#include "common/a_star_frontier.hpp"
+#include "common/vec2.hpp"
 
 // TODO: make no alloc a_star
 // if found path is too large, store only the first segment and report how many nodes are in the full path
@@ -16,32 +21,47 @@
 
 // prefixing template types with t_ to see how ugly it looks
 
-template <class t_node_type, class t_node_hasher_type, class weight_type, class t_list_adjacent_func, class t_transition_cost_func, class t_heuristic_func>
-std::vector<t_node_type> a_star(t_node_type const& start, t_node_type const& finish, t_list_adjacent_func adj_func, t_transition_cost_func cost_func, t_heuristic_func heur_func)
+// Storage of the generic a_star(), kept between searches so that repeated searches reuse the
+// frontier, the path and the buckets of the hash maps instead of building them again.
+// Everything is cleared before each search, the path of the last search lives here too.
+// 't_frontier_type' is the open set, see common/a_star_frontier.hpp.
+template <class t_node_type, class t_node_hasher_type, class weight_type, class t_frontier_type = binary_heap_frontier<t_node_type, weight_type>>
+class a_star_workspace
 {
-  struct weighted_node_type
-  {
-    t_node_type node;
-    weight_type weight;
+public:
+  template <class n, class h, class w, class f, class t_list_adjacent_func, class t_transition_cost_func, class t_heuristic_func>
+  friend std::vector<n> const& a_star(a_star_workspace<n, h, w, f>& workspace, n const& start, n const& finish, t_list_adjacent_func adj_func, t_transition_cost_func cost_func, t_heuristic_func heur_func);
 
-    bool operator<(weighted_node_type const& other) const
-    {
-      // because default priority queue sorts by highest priority
-      return weight > other.weight;
-    }
-  };
+private:
+  void reset()
+  {
+    cost_so_far.clear();
+    came_from.clear();
+    frontier.clear();
+    path.clear();
+  }
 
-  std::priority_queue<weighted_node_type> frontier;
-  frontier.push({ start, heur_func(start, finish) });
   std::unordered_map<t_node_type, weight_type, t_node_hasher_type> cost_so_far;
   std::unordered_map<t_node_type, t_node_type, t_node_hasher_type> came_from;
+  t_frontier_type frontier;
+  std::vector<t_node_type> path;
+};
+
+// Returns the path stored in 'workspace', valid until its next search.
+template <class t_node_type, class t_node_hasher_type, class weight_type, class t_frontier_type, class t_list_adjacent_func, class t_transition_cost_func, class t_heuristic_func>
+std::vector<t_node_type> const& a_star(a_star_workspace<t_node_type, t_node_hasher_type, weight_type, t_frontier_type>& workspace, t_node_type const& start, t_node_type const& finish, t_list_adjacent_func adj_func, t_transition_cost_func cost_func, t_heuristic_func heur_func)
+{
+  workspace.reset();
+  t_frontier_type& frontier = workspace.frontier;
+  std::unordered_map<t_node_type, weight_type, t_node_hasher_type>& cost_so_far = workspace.cost_so_far;
+  std::unordered_map<t_node_type, t_node_type, t_node_hasher_type>& came_from = workspace.came_from;
+
+  frontier.push(start, heur_func(start, finish));
   cost_so_far[start] = 0;
 
-  while (frontier.size() > 0)
+  while (!frontier.empty())
   {
-    weighted_node_type cur_weighted_node = frontier.top();
-    t_node_type const& cur = cur_weighted_node.node;
-    frontier.pop();
+    const t_node_type cur = frontier.pop();
 
     if (cur == finish)
     {
@@ -56,15 +76,18 @@ std::vector<t_node_type> a_star(t_node_type const& start, t_node_type const& fin
       {
         came_from[next] = cur;
         cost_so_far[next] = new_cost;
-        frontier.push({ next, new_cost + heur_func(next, finish) });
+        frontier.push(next, new_cost + heur_func(next, finish));
       }
     }
   }
 
+  std::vector<t_node_type>& path = workspace.path;
   if (came_from.find(finish) == came_from.end())
-    return {start};
+  {
+    path.push_back(start);
+    return path;
+  }
 
-  std::vector<t_node_type> path;
   path.push_back(finish);
   t_node_type p = finish;
   while (!(p == start))
@@ -75,3 +98,201 @@ std::vector<t_node_type> a_star(t_node_type const& start, t_node_type const& fin
 
   return path;
 }
+
+// a_star() with a workspace of its own, for one-off searches.
+// 't_frontier_type' is the open set, see common/a_star_frontier.hpp.
+template <class t_node_type, class t_node_hasher_type, class weight_type, class t_list_adjacent_func, class t_transition_cost_func, class t_heuristic_func, class t_frontier_type = binary_heap_frontier<t_node_type, weight_type>>
+std::vector<t_node_type> a_star(t_node_type const& start, t_node_type const& finish, t_list_adjacent_func adj_func, t_transition_cost_func cost_func, t_heuristic_func heur_func)
+{
+  a_star_workspace<t_node_type, t_node_hasher_type, weight_type, t_frontier_type> workspace;
+  return a_star(workspace, start, finish, adj_func, cost_func, heur_func);
+}
+
+// Rectangle of grid cells, 'origin' is the cell with the lowest x and y.
+struct grid_bounds
+{
+  vec2 origin;
+  int width;
+  int height;
+
+  bool contains(vec2 p) const
+  {
+    return p.x >= origin.x && p.x < origin.x + width && p.y >= origin.y && p.y < origin.y + height;
+  }
+
+  size_t size() const
+  {
+    return (size_t)width * height;
+  }
+
+  size_t index(vec2 p) const
+  {
+    return (size_t)(p.x - origin.x) + (size_t)(p.y - origin.y) * width;
+  }
+
+  vec2 cell(size_t index) const
+  {
+    return { origin.x + (int)(index % width), origin.y + (int)(index / width) };
+  }
+};
+
+// Neighbours of one grid cell, filled in by the adjacency function of the grid a_star().
+// Lives on the stack of the search and is reused for every node.
+class grid_neighbours
+{
+public:
+  static constexpr int capacity = 8;
+
+  void push_back(vec2 p)
+  {
+    assert(count < capacity);
+    cells[count++] = p;
+  }
+
+  void clear()
+  {
+    count = 0;
+  }
+
+  vec2 const* begin() const
+  {
+    return cells;
+  }
+
+  vec2 const* end() const
+  {
+    return cells + count;
+  }
+
+private:
+  vec2 cells[capacity];
+  int count = 0;
+};
+
+// Storage of the grid a_star(), kept between searches so that repeated searches (all pairs of
+// points on a map, ...) stop allocating once the buffers have grown to fit.
+// Only the cells a search touched are reset before the next one, a whole-grid reset happens only
+// when the grid size changes. The path of the last search lives here too.
+// 't_frontier_type' is the open set, see common/a_star_frontier.hpp.
+template <class weight_type, class t_frontier_type = binary_heap_frontier<vec2, weight_type>>
+class a_star_grid_workspace
+{
+public:
+  template <class w, class f, class t_list_adjacent_func, class t_transition_cost_func, class t_heuristic_func>
+  friend std::vector<vec2> const& a_star(a_star_grid_workspace<w, f>& workspace, grid_bounds const& bounds, vec2 const& start, vec2 const& finish, t_list_adjacent_func adj_func, t_transition_cost_func cost_func, t_heuristic_func heur_func);
+
+private:
+  static constexpr size_t no_node = std::numeric_limits<size_t>::max();
+
+  // Restores every cell to unreached for a search over a grid of 'size' cells.
+  void reset(size_t size)
+  {
+    if (cost_so_far.size() != size)
+    {
+      cost_so_far.assign(size, std::numeric_limits<weight_type>::max());
+      came_from.assign(size, no_node);
+    }
+    else
+    {
+      for (size_t index : touched)
+      {
+        cost_so_far[index] = std::numeric_limits<weight_type>::max();
+        came_from[index] = no_node;
+      }
+    }
+    touched.clear();
+    frontier.clear();
+    path.clear();
+  }
+
+  // Unreached cells cost the maximum, so any path to them is an improvement.
+  std::vector<weight_type> cost_so_far;
+  std::vector<size_t> came_from;
+  // Cells whose cost was set by the current search.
+  std::vector<size_t> touched;
+  t_frontier_type frontier;
+  std::vector<vec2> path;
+};
+
+template <class weight_type, class t_frontier_type>
+constexpr size_t a_star_grid_workspace<weight_type, t_frontier_type>::no_node;
+
+// a_star() for nodes that are cells of a known rectangle.
+// Costs and predecessors live in flat arrays indexed by x + y * width instead of hash maps, and
+// adj_func(vec2 p, grid_neighbours& out) appends the neighbours of p, all of which must be inside
+// 'bounds', to a buffer instead of returning a vector. With the same frontier type it expands
+// nodes in the same order as the generic version, so both return the same path.
+// Returns the path stored in 'workspace', valid until its next search.
+template <class weight_type, class t_frontier_type, class t_list_adjacent_func, class t_transition_cost_func, class t_heuristic_func>
+std::vector<vec2> const& a_star(a_star_grid_workspace<weight_type, t_frontier_type>& workspace, grid_bounds const& bounds, vec2 const& start, vec2 const& finish, t_list_adjacent_func adj_func, t_transition_cost_func cost_func, t_heuristic_func heur_func)
+{
+  const size_t no_node = a_star_grid_workspace<weight_type, t_frontier_type>::no_node;
+
+  assert(bounds.contains(start) && bounds.contains(finish));
+  workspace.reset(bounds.size());
+  std::vector<weight_type>& cost_so_far = workspace.cost_so_far;
+  std::vector<size_t>& came_from = workspace.came_from;
+  t_frontier_type& frontier = workspace.frontier;
+
+  frontier.push(start, heur_func(start, finish));
+  cost_so_far[bounds.index(start)] = 0;
+  workspace.touched.push_back(bounds.index(start));
+
+  grid_neighbours neighbours;
+  while (!frontier.empty())
+  {
+    const vec2 cur = frontier.pop();
+
+    if (cur == finish)
+    {
+      break;
+    }
+
+    const size_t cur_index = bounds.index(cur);
+    const weight_type cost_at_cur = cost_so_far[cur_index];
+    neighbours.clear();
+    adj_func(cur, neighbours);
+    for (vec2 const& next : neighbours)
+    {
+      assert(bounds.contains(next));
+      const size_t next_index = bounds.index(next);
+      const weight_type new_cost = cost_at_cur + cost_func(cur, next);
+      if (new_cost < cost_so_far[next_index])
+      {
+        if (came_from[next_index] == no_node)
+        {
+          workspace.touched.push_back(next_index);
+        }
+        came_from[next_index] = cur_index;
+        cost_so_far[next_index] = new_cost;
+        frontier.push(next, new_cost + heur_func(next, finish));
+      }
+    }
+  }
+
+  std::vector<vec2>& path = workspace.path;
+  if (came_from[bounds.index(finish)] == no_node)
+  {
+    path.push_back(start);
+    return path;
+  }
+
+  path.push_back(finish);
+  size_t p = bounds.index(finish);
+  const size_t start_index = bounds.index(start);
+  while (p != start_index)
+  {
+    p = came_from[p];
+    path.push_back(bounds.cell(p));
+  }
+
+  return path;
+}
+
+// Grid a_star() with a workspace of its own, for one-off searches.
+template <class weight_type, class t_frontier_type = binary_heap_frontier<vec2, weight_type>, class t_list_adjacent_func, class t_transition_cost_func, class t_heuristic_func>
+std::vector<vec2> a_star(grid_bounds const& bounds, vec2 const& start, vec2 const& finish, t_list_adjacent_func adj_func, t_transition_cost_func cost_func, t_heuristic_func heur_func)
+{
+  a_star_grid_workspace<weight_type, t_frontier_type> workspace;
+  return a_star(workspace, bounds, start, finish, adj_func, cost_func, heur_func);
+}
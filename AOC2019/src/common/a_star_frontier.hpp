@@ -0,0 +1,243 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Frontiers (open sets) for a_star(), all with the same interface:
+//
+//   void clear();                              // keeps the storage for the next search
+//   bool empty() const;
+//   void push(node_type const& node, key_type key);
+//   node_type pop();                           // removes a node with the lowest key
+//
+// Nodes with equal keys come out in a different order in each of them, so with several
+// shortest paths each may return a different one, always of the same cost.
+
+// Binary heap, pops in exactly the order of std::priority_queue. Any key type.
+template <class node_type, class key_type>
+class binary_heap_frontier
+{
+public:
+  void clear()
+  {
+    heap.clear();
+  }
+
+  bool empty() const
+  {
+    return heap.empty();
+  }
+
+  void push(node_type const& node, key_type key)
+  {
+    heap.push_back({ node, key });
+    std::push_heap(heap.begin(), heap.end());
+  }
+
+  node_type pop()
+  {
+    std::pop_heap(heap.begin(), heap.end());
+    node_type node = heap.back().node;
+    heap.pop_back();
+    return node;
+  }
+
+private:
+  struct entry
+  {
+    node_type node;
+    key_type key;
+
+    bool operator<(entry const& other) const
+    {
+      // because the heap keeps the highest priority on top
+      return key > other.key;
+    }
+  };
+
+  std::vector<entry> heap;
+};
+
+// Dial's bucket queue: a ring of buckets, one per key between the lowest and the highest key
+// queued, so push and pop are O(1) plus a scan over empty buckets.
+// For integer keys that stay close together, as in searches with small integer edge costs,
+// where queued keys never span more than the largest edge cost plus the heuristic's step.
+// The ring grows to fit any span, but gets slow when keys are far apart.
+template <class node_type, class key_type>
+class bucket_frontier
+{
+public:
+  void clear()
+  {
+    for (std::vector<node_type>& bucket : buckets)
+    {
+      bucket.clear();
+    }
+    count = 0;
+  }
+
+  bool empty() const
+  {
+    return count == 0;
+  }
+
+  void push(node_type const& node, key_type key)
+  {
+    if (buckets.empty())
+    {
+      buckets.resize(8);
+    }
+    if (count == 0)
+    {
+      lowest = key;
+      highest = key;
+    }
+    else if (key < lowest || key > highest)
+    {
+      const key_type new_lowest = std::min(lowest, key);
+      const key_type new_highest = std::max(highest, key);
+      if ((uint64_t)(new_highest - new_lowest) >= buckets.size())
+      {
+        grow((uint64_t)(new_highest - new_lowest) + 1);
+      }
+      lowest = new_lowest;
+      highest = new_highest;
+    }
+    buckets[slot(key)].push_back(node);
+    count++;
+  }
+
+  node_type pop()
+  {
+    assert(count > 0);
+    while (buckets[slot(lowest)].empty())
+    {
+      lowest++;
+    }
+    std::vector<node_type>& bucket = buckets[slot(lowest)];
+    node_type node = bucket.back();
+    bucket.pop_back();
+    count--;
+    return node;
+  }
+
+private:
+  size_t slot(key_type key) const
+  {
+    return (size_t)((uint64_t)key & (buckets.size() - 1));
+  }
+
+  // Resizes the ring to a power of two of at least 'span' buckets.
+  void grow(uint64_t span)
+  {
+    size_t new_size = buckets.size();
+    while (new_size < span)
+    {
+      new_size *= 2;
+    }
+    std::vector<std::vector<node_type>> old_buckets(new_size);
+    old_buckets.swap(buckets);
+    // Every queued key is within one old ring size from 'lowest'.
+    const uint64_t old_mask = old_buckets.size() - 1;
+    for (size_t i = 0; i < old_buckets.size(); i++)
+    {
+      const key_type key = lowest + (key_type)((i - ((uint64_t)lowest & old_mask)) & old_mask);
+      buckets[slot(key)].swap(old_buckets[i]);
+    }
+  }
+
+  std::vector<std::vector<node_type>> buckets;
+  size_t count = 0;
+  // Bounds of the queued keys, 'lowest' only moves up while popping.
+  key_type lowest = 0;
+  key_type highest = 0;
+};
+
+// Radix heap for monotone non-negative integer keys: every key pushed must be at least the key
+// of the last node popped, which holds for Dijkstra and for A* with a consistent heuristic.
+// Bucket b holds the keys whose highest bit that differs from the last popped key is bit b - 1,
+// a node moves down at most 64 times over its life, whatever the spread of the keys.
+template <class node_type, class key_type>
+class radix_heap_frontier
+{
+public:
+  void clear()
+  {
+    for (std::vector<entry>& bucket : buckets)
+    {
+      bucket.clear();
+    }
+    count = 0;
+    last = 0;
+  }
+
+  bool empty() const
+  {
+    return count == 0;
+  }
+
+  void push(node_type const& node, key_type key)
+  {
+    assert(key >= 0 && (uint64_t)key >= last);
+    buckets[bucket_of((uint64_t)key)].push_back({ node, (uint64_t)key });
+    count++;
+  }
+
+  node_type pop()
+  {
+    assert(count > 0);
+    if (buckets[0].empty())
+    {
+      size_t b = 1;
+      while (buckets[b].empty())
+      {
+        b++;
+      }
+      // The new minimum splits the bucket: every key in it lands in a lower bucket.
+      last = std::min_element(buckets[b].begin(), buckets[b].end(),
+        [](entry const& l, entry const& r) { return l.key < r.key; })->key;
+      for (entry const& e : buckets[b])
+      {
+        buckets[bucket_of(e.key)].push_back(e);
+      }
+      buckets[b].clear();
+    }
+    node_type node = buckets[0].back().node;
+    buckets[0].pop_back();
+    count--;
+    return node;
+  }
+
+private:
+  struct entry
+  {
+    node_type node;
+    uint64_t key;
+  };
+
+  size_t bucket_of(uint64_t key) const
+  {
+    return key == last ? 0 : 64 - leading_zeros(key ^ last);
+  }
+
+  static int leading_zeros(uint64_t x)
+  {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, x);
+    return 63 - (int)index;
+#else
+    return __builtin_clzll(x);
+#endif
+  }
+
+  std::vector<entry> buckets[65];
+  size_t count = 0;
+  uint64_t last = 0;
+};
@@ -0,0 +1,275 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "common/vec2.hpp"
+
+// Unbounded 2D grid, for maps that grow in any direction while a robot explores them.
+//
+// Cells live in dense 64x64 chunks, created when the first cell in them is set, with one bit
+// per cell telling whether it was set. A lookup finds the chunk through a hash map, skipped
+// when it is the chunk of the previous lookup, which it mostly is for robots moving a step at a
+// time, and then indexes the chunk's array.
+// for_each() visits chunks in creation order and their cells row by row, skipping empty rows.
+// The previous chunk is cached even by const lookups, so share a grid between threads only
+// with external locking.
+template <class t_value_type>
+class chunked_grid
+{
+public:
+  using value_type = t_value_type;
+
+  static constexpr int chunk_bits = 6;
+  static constexpr int chunk_size = 1 << chunk_bits;
+
+  // 'empty_value' is what get() returns for cells that were never set.
+  explicit chunked_grid(value_type const& empty_value = value_type{}) : empty_value{ empty_value }
+  {
+  }
+
+  // Number of set cells.
+  size_t size() const
+  {
+    return num_cells;
+  }
+
+  bool empty() const
+  {
+    return num_cells == 0;
+  }
+
+  // Corners of the smallest box holding every set cell, min_cell() > max_cell() when empty.
+  vec2 min_cell() const
+  {
+    return min_set;
+  }
+
+  vec2 max_cell() const
+  {
+    return max_set;
+  }
+
+  bool contains(vec2 p) const
+  {
+    return find(p) != nullptr;
+  }
+
+  // The cell, or nullptr if it was never set.
+  value_type const* find(vec2 p) const
+  {
+    const int c = find_chunk(chunk_of(p));
+    if (c < 0 || !chunks[c].is_set(p))
+    {
+      return nullptr;
+    }
+    return &chunks[c].at(p);
+  }
+
+  value_type* find(vec2 p)
+  {
+    return const_cast<value_type*>(static_cast<chunked_grid const&>(*this).find(p));
+  }
+
+  // Value of a set cell.
+  value_type const& at(vec2 p) const
+  {
+    value_type const* value = find(p);
+    assert(value != nullptr);
+    return *value;
+  }
+
+  value_type& at(vec2 p)
+  {
+    value_type* value = find(p);
+    assert(value != nullptr);
+    return *value;
+  }
+
+  // Value of the cell, the empty value if it was never set.
+  value_type const& get(vec2 p) const
+  {
+    value_type const* value = find(p);
+    return value != nullptr ? *value : empty_value;
+  }
+
+  // The cell, set to the empty value first if it was never set.
+  value_type& operator[](vec2 p)
+  {
+    chunk& ch = chunks[find_or_add_chunk(chunk_of(p))];
+    if (!ch.is_set(p))
+    {
+      ch.mark_set(p);
+      num_cells++;
+      min_set = { std::min(min_set.x, p.x), std::min(min_set.y, p.y) };
+      max_set = { std::max(max_set.x, p.x), std::max(max_set.y, p.y) };
+    }
+    return ch.at(p);
+  }
+
+  // Calls f(vec2, value_type const&) on every set cell.
+  template <class func>
+  void for_each(func f) const
+  {
+    for (chunk const& ch : chunks)
+    {
+      ch.for_each(f);
+    }
+  }
+
+  // Calls f(vec2, value_type&) on every set cell.
+  template <class func>
+  void for_each(func f)
+  {
+    for (chunk& ch : chunks)
+    {
+      ch.for_each(f);
+    }
+  }
+
+  // True if pred(vec2, value_type const&) holds for a set cell, stops at the first one.
+  template <class func>
+  bool any_of(func pred) const
+  {
+    for (chunk const& ch : chunks)
+    {
+      if (ch.any_of(pred))
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  struct chunk
+  {
+    explicit chunk(vec2 origin, value_type const& empty_value)
+      : origin{ origin }, cells(chunk_size * chunk_size, empty_value)
+    {
+    }
+
+    static int index(vec2 p)
+    {
+      return (p.y & (chunk_size - 1)) * chunk_size + (p.x & (chunk_size - 1));
+    }
+
+    bool is_set(vec2 p) const
+    {
+      return (set_rows[p.y & (chunk_size - 1)] >> (p.x & (chunk_size - 1))) & 1;
+    }
+
+    void mark_set(vec2 p)
+    {
+      set_rows[p.y & (chunk_size - 1)] |= uint64_t{ 1 } << (p.x & (chunk_size - 1));
+    }
+
+    value_type const& at(vec2 p) const
+    {
+      return cells[index(p)];
+    }
+
+    value_type& at(vec2 p)
+    {
+      return cells[index(p)];
+    }
+
+    template <class func>
+    void for_each(func& f) const
+    {
+      for_each_set(*this, f);
+    }
+
+    template <class func>
+    void for_each(func& f)
+    {
+      for_each_set(*this, f);
+    }
+
+    template <class func>
+    bool any_of(func& pred) const
+    {
+      for (int y = 0; y < chunk_size; y++)
+      {
+        for (int x = 0; x < chunk_size && set_rows[y] >> x != 0; x++)
+        {
+          if (((set_rows[y] >> x) & 1) && pred(vec2{ origin.x + x, origin.y + y }, cells[y * chunk_size + x]))
+          {
+            return true;
+          }
+        }
+      }
+      return false;
+    }
+
+    // First cell of the chunk.
+    vec2 origin;
+    // Bit x of row y is set if cell (x, y) was set.
+    uint64_t set_rows[chunk_size] = {};
+    std::vector<value_type> cells;
+  };
+
+  template <class chunk_type, class func>
+  static void for_each_set(chunk_type& ch, func& f)
+  {
+    for (int y = 0; y < chunk_size; y++)
+    {
+      // Stops at the last set cell of the row.
+      for (int x = 0; x < chunk_size && ch.set_rows[y] >> x != 0; x++)
+      {
+        if ((ch.set_rows[y] >> x) & 1)
+        {
+          f(vec2{ ch.origin.x + x, ch.origin.y + y }, ch.cells[y * chunk_size + x]);
+        }
+      }
+    }
+  }
+
+  // Chunk coordinates, rounding towards negative infinity.
+  static vec2 chunk_of(vec2 p)
+  {
+    return { p.x >> chunk_bits, p.y >> chunk_bits };
+  }
+
+  int find_chunk(vec2 c) const
+  {
+    if (last_chunk >= 0 && c == last_chunk_coords)
+    {
+      return last_chunk;
+    }
+    auto it = chunk_indices.find(c);
+    if (it == chunk_indices.end())
+    {
+      return -1;
+    }
+    last_chunk_coords = c;
+    last_chunk = it->second;
+    return last_chunk;
+  }
+
+  int find_or_add_chunk(vec2 c)
+  {
+    int index = find_chunk(c);
+    if (index < 0)
+    {
+      index = (int)chunks.size();
+      chunks.emplace_back(vec2{ c.x * chunk_size, c.y * chunk_size }, empty_value);
+      chunk_indices.emplace(c, index);
+      last_chunk_coords = c;
+      last_chunk = index;
+    }
+    return index;
+  }
+
+  value_type empty_value;
+  std::vector<chunk> chunks;
+  std::unordered_map<vec2, int, vec2_hasher> chunk_indices;
+  mutable vec2 last_chunk_coords;
+  mutable int last_chunk = -1;
+  size_t num_cells = 0;
+  vec2 min_set{ INT_MAX, INT_MAX };
+  vec2 max_set{ INT_MIN, INT_MIN };
+};
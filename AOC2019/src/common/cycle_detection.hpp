@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+
+// Cycle detection for simulations x0, x1 = step(x0), x2 = step(x1), ... over a finite set of
+// states, so that they eventually repeat. Both functions keep O(1) states in memory, whatever
+// the length of the cycle, so states should be small and cheap to copy and compare.
+
+template <class state_type>
+struct cycle_info
+{
+  // Index of the first state on the cycle, also the first one that comes back.
+  uint64_t start;
+  // Steps from a state on the cycle back to itself.
+  uint64_t length;
+  // State number 'start'.
+  state_type first_repeated;
+};
+
+// Brent's algorithm: about start + 2 * length calls to step() to find the length, and
+// start + length more to find the start.
+//   step: state_type(state_type const&)
+template <class state_type, class step_func>
+cycle_info<state_type> find_cycle(state_type const& initial, step_func step)
+{
+  // The tortoise waits at powers of two for the hare to come around.
+  uint64_t power = 1;
+  uint64_t length = 1;
+  state_type tortoise = initial;
+  state_type hare = step(initial);
+  while (!(tortoise == hare))
+  {
+    if (power == length)
+    {
+      tortoise = hare;
+      power *= 2;
+      length = 0;
+    }
+    hare = step(hare);
+    length++;
+  }
+
+  // With the hare one cycle ahead, both meet at the start.
+  tortoise = initial;
+  hare = initial;
+  for (uint64_t i = 0; i < length; i++)
+  {
+    hare = step(hare);
+  }
+  uint64_t start = 0;
+  while (!(tortoise == hare))
+  {
+    tortoise = step(tortoise);
+    hare = step(hare);
+    start++;
+  }
+  return { start, length, tortoise };
+}
+
+// Length of the cycle of a simulation known to start on it, as reversible ones do (every
+// state has a single predecessor, so there is no lead-in): steps until 'initial' comes back,
+// one call to step() each.
+template <class state_type, class step_func>
+uint64_t find_period(state_type const& initial, step_func step)
+{
+  uint64_t length = 1;
+  state_type state = step(initial);
+  while (!(state == initial))
+  {
+    state = step(state);
+    length++;
+  }
+  return length;
+}
+
+// find_period() for states too big to copy every step, advanced in place instead.
+//   advance: void(state_type&)
+template <class state_type, class advance_func>
+uint64_t find_period_in_place(state_type const& initial, advance_func advance)
+{
+  uint64_t length = 1;
+  state_type state = initial;
+  advance(state);
+  while (!(state == initial))
+  {
+    advance(state);
+    length++;
+  }
+  return length;
+}
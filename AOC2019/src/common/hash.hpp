@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+
+// Hashing for composite keys in unordered containers.
+//
+// std::unordered_map takes bucket = hash % bucket_count, so every bit of the key has to reach
+// the low bits of the hash: keys are packed into 64 bits and run through a full avalanche mix.
+
+// Finalizer of splitmix64: each input bit flips about half of the output bits.
+inline uint64_t hash_mix(uint64_t h)
+{
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ull;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebull;
+  h ^= h >> 31;
+  return h;
+}
+
+// Two 32-bit values in one word, without sign extension mixing them.
+inline uint64_t hash_pack(int32_t high, int32_t low)
+{
+  return ((uint64_t)(uint32_t)high << 32) | (uint32_t)low;
+}
+
+// Hash of a key with 'value' appended to the parts already folded into 'seed'.
+inline uint64_t hash_combine(uint64_t seed, uint64_t value)
+{
+  return hash_mix(seed + 0x9e3779b97f4a7c15ull + value);
+}
@@ -0,0 +1,382 @@
+#include <algorithm>
+#include <cassert>
+
+#include "common/intcode_batch.hpp"
+
+namespace
+{
+  // Upper bound on cells kept for all lanes together, addresses past it make lanes diverge.
+  const uint64_t max_batch_cells = (uint64_t)1 << 22;
+
+  // End of the memory page holding 'address', see intcode_memory::size().
+  uint64_t page_end(uint64_t address)
+  {
+    return ((address >> intcode_memory::page_bits) + 1) << intcode_memory::page_bits;
+  }
+}
+
+intcode_batch::intcode_batch(intcode_program const& program, size_t num_lanes)
+  : lanes(num_lanes)
+  , image(program)
+  , base(program)
+  , inputs(num_lanes)
+  , outputs(num_lanes)
+{
+  assert(num_lanes > 0);
+  extent = program.empty() ? 0 : page_end(program.size() - 1);
+  max_rows = std::max(extent, (max_batch_cells / lanes) & ~intcode_memory::page_mask);
+  cells.resize(extent * lanes);
+  for (uint64_t address = 0; address < program.size(); address++)
+  {
+    std::fill(row(address), row(address) + lanes, program[address]);
+  }
+  uniform.resize(extent, 1);
+  written.resize(extent, 0);
+  decoded.resize(extent);
+}
+
+void intcode_batch::reset()
+{
+  for (uint64_t address : written_addresses)
+  {
+    const int64_t value = address < image.size() ? image[address] : 0;
+    std::fill(row(address), row(address) + lanes, value);
+    uniform[address] = 1;
+    written[address] = 0;
+    decoded[address].op = operation::undecoded;
+  }
+  written_addresses.clear();
+  extent = image.empty() ? 0 : page_end(image.size() - 1);
+
+  int64_t discarded;
+  for (size_t lane = 0; lane < lanes; lane++)
+  {
+    while (inputs[lane].pop(discarded))
+    {
+    }
+    while (outputs[lane].pop(discarded))
+    {
+    }
+  }
+  lane_machines.clear();
+  lockstep = true;
+  state = execution_state::ready;
+  ip = 0;
+  relative_base = 0;
+}
+
+void intcode_batch::push_input(size_t lane, int64_t value)
+{
+  if (lockstep)
+  {
+    inputs[lane].push(value);
+  }
+  else
+  {
+    lane_machines[lane].push_input(value);
+  }
+}
+
+std::pair<bool, int64_t> intcode_batch::pop_output(size_t lane)
+{
+  int64_t value = 0;
+  if (outputs[lane].pop(value))
+  {
+    return {true, value};
+  }
+  return {false, 0};
+}
+
+intcode_batch::execution_state intcode_batch::get_state(size_t lane) const
+{
+  return lockstep ? state : lane_machines[lane].get_state();
+}
+
+void intcode_batch::run()
+{
+  if (lockstep)
+  {
+    if (state == execution_state::awaiting_input)
+    {
+      state = execution_state::ready;
+    }
+    if (state == execution_state::ready)
+    {
+      state = run_lockstep();
+    }
+    if (lockstep)
+    {
+      return;
+    }
+  }
+
+  int64_t values[64];
+  for (size_t lane = 0; lane < lanes; lane++)
+  {
+    intcode_machine& machine = lane_machines[lane];
+    machine.run();
+    size_t count;
+    while ((count = machine.drain_outputs(values, 64)) > 0)
+    {
+      outputs[lane].push_bulk(values, count);
+    }
+  }
+}
+
+bool intcode_batch::arg_address(intcode_instruction const& instr, int arg, uint64_t& address) const
+{
+  const uint64_t cell = ip + arg + 1;
+  switch (instr.modes[arg])
+  {
+    case arg_mode::immediate:
+      address = cell;
+      return true;
+    case arg_mode::position:
+      address = (uint64_t)cells[cell * lanes];
+      break;
+    case arg_mode::relative:
+      address = (uint64_t)(cells[cell * lanes] + relative_base);
+      break;
+    default:
+      return false;
+  }
+  return uniform[cell] && address < max_rows;
+}
+
+void intcode_batch::ensure_rows(uint64_t address)
+{
+  const uint64_t rows = uniform.size();
+  if (address < rows)
+  {
+    return;
+  }
+  const uint64_t new_rows = std::min(max_rows, std::max(page_end(address), 2 * rows));
+  cells.resize(new_rows * lanes, 0);
+  uniform.resize(new_rows, 1);
+  written.resize(new_rows, 0);
+  decoded.resize(new_rows);
+}
+
+void intcode_batch::mark_written(uint64_t address, bool is_uniform)
+{
+  uniform[address] = is_uniform;
+  decoded[address].op = operation::undecoded;
+  if (!written[address])
+  {
+    written[address] = 1;
+    written_addresses.push_back(address);
+  }
+  extent = std::max(extent, page_end(address));
+}
+
+// Each instruction first checks that it behaves the same in every lane, then runs as a loop over lanes.
+// Anything else (lane-dependent jumps or addresses, partial input, memory edge cases) splits the batch
+// before the instruction executes, and the per-lane machines take it from there.
+intcode_batch::execution_state intcode_batch::run_lockstep()
+{
+  uint64_t a[3];
+  for (;;)
+  {
+    // Instructions whose operands could cross the end of memory are left to the machines.
+    if (ip + 3 >= extent || !uniform[ip])
+    {
+      diverge();
+      return execution_state::ready;
+    }
+    if (decoded[ip].op == operation::undecoded)
+    {
+      decoded[ip] = decode_intcode_instruction(cells[ip * lanes]);
+    }
+    const intcode_instruction instr = decoded[ip];
+
+    bool same_addresses = true;
+    uint64_t highest = 0;
+    for (int i = 0; i < instr.num_args && same_addresses; i++)
+    {
+      same_addresses = arg_address(instr, i, a[i]);
+      highest = std::max(highest, a[i]);
+    }
+    if (!same_addresses)
+    {
+      diverge();
+      return execution_state::ready;
+    }
+    ensure_rows(highest);
+
+    switch (instr.op)
+    {
+      case operation::add:
+      {
+        int64_t const* x = row(a[0]);
+        int64_t const* y = row(a[1]);
+        int64_t* d = row(a[2]);
+        const bool is_uniform = uniform[a[0]] && uniform[a[1]];
+        for (size_t l = 0; l < lanes; l++)
+        {
+          d[l] = x[l] + y[l];
+        }
+        mark_written(a[2], is_uniform);
+        ip += 4;
+      }
+      break;
+      case operation::multiply:
+      {
+        int64_t const* x = row(a[0]);
+        int64_t const* y = row(a[1]);
+        int64_t* d = row(a[2]);
+        const bool is_uniform = uniform[a[0]] && uniform[a[1]];
+        for (size_t l = 0; l < lanes; l++)
+        {
+          d[l] = x[l] * y[l];
+        }
+        mark_written(a[2], is_uniform);
+        ip += 4;
+      }
+      break;
+      case operation::read_input:
+      {
+        size_t num_ready = 0;
+        for (size_t l = 0; l < lanes; l++)
+        {
+          num_ready += inputs[l].empty() ? 0 : 1;
+        }
+        if (num_ready == 0)
+        {
+          return execution_state::awaiting_input;
+        }
+        if (num_ready != lanes)
+        {
+          diverge();
+          return execution_state::ready;
+        }
+        int64_t* d = row(a[0]);
+        for (size_t l = 0; l < lanes; l++)
+        {
+          inputs[l].pop(d[l]);
+        }
+        mark_written(a[0], false);
+        ip += 2;
+      }
+      break;
+      case operation::write_output:
+      {
+        int64_t const* x = row(a[0]);
+        for (size_t l = 0; l < lanes; l++)
+        {
+          outputs[l].push(x[l]);
+        }
+        ip += 2;
+      }
+      break;
+      case operation::jump_if_true:
+      case operation::jump_if_false:
+      {
+        int64_t const* x = row(a[0]);
+        int64_t const* y = row(a[1]);
+        size_t num_nonzero = 0;
+        for (size_t l = 0; l < lanes; l++)
+        {
+          num_nonzero += x[l] != 0 ? 1 : 0;
+        }
+        if (num_nonzero != 0 && num_nonzero != lanes)
+        {
+          diverge();
+          return execution_state::ready;
+        }
+        const bool taken = (num_nonzero != 0) == (instr.op == operation::jump_if_true);
+        if (!taken)
+        {
+          ip += 3;
+        }
+        else if (uniform[a[1]] || std::all_of(y, y + lanes, [y](int64_t v) { return v == y[0]; }))
+        {
+          ip = y[0];
+        }
+        else
+        {
+          diverge();
+          return execution_state::ready;
+        }
+      }
+      break;
+      case operation::less_than:
+      {
+        int64_t const* x = row(a[0]);
+        int64_t const* y = row(a[1]);
+        int64_t* d = row(a[2]);
+        const bool is_uniform = uniform[a[0]] && uniform[a[1]];
+        for (size_t l = 0; l < lanes; l++)
+        {
+          d[l] = x[l] < y[l] ? 1 : 0;
+        }
+        mark_written(a[2], is_uniform);
+        ip += 4;
+      }
+      break;
+      case operation::equals:
+      {
+        int64_t const* x = row(a[0]);
+        int64_t const* y = row(a[1]);
+        int64_t* d = row(a[2]);
+        const bool is_uniform = uniform[a[0]] && uniform[a[1]];
+        for (size_t l = 0; l < lanes; l++)
+        {
+          d[l] = x[l] == y[l] ? 1 : 0;
+        }
+        mark_written(a[2], is_uniform);
+        ip += 4;
+      }
+      break;
+      case operation::change_relative_base:
+      {
+        if (!uniform[a[0]])
+        {
+          diverge();
+          return execution_state::ready;
+        }
+        relative_base += row(a[0])[0];
+        ip += 2;
+      }
+      break;
+      case operation::halt:
+        return execution_state::halted;
+      case operation::invalid:
+      default:
+        return execution_state::invalid_op;
+    }
+  }
+}
+
+void intcode_batch::diverge()
+{
+  lane_machines.clear();
+  lane_machines.reserve(lanes);
+  // Same rule as intcode_machine::modify_program(), lanes can't use a translation of code they changed.
+  bool translation_valid = base.native != nullptr;
+  for (uint64_t address : written_addresses)
+  {
+    translation_valid = translation_valid && !base.native->is_translated(address);
+  }
+  int64_t value;
+  for (size_t lane = 0; lane < lanes; lane++)
+  {
+    lane_machines.push_back(base.fork());
+    intcode_machine& machine = lane_machines.back();
+    for (uint64_t address : written_addresses)
+    {
+      machine.program.write(address, cells[address * lanes + lane]);
+    }
+    machine.ip = ip;
+    machine.relative_base = relative_base;
+    machine.state = execution_state::ready;
+    if (!translation_valid)
+    {
+      machine.native = nullptr;
+    }
+    while (inputs[lane].pop(value))
+    {
+      machine.push_input(value);
+    }
+  }
+  lockstep = false;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "common/intcode_instruction.hpp"
+#include "common/intcode_machine.hpp"
+
+// Runs many instances (lanes) of one Intcode program, each with its own input and output.
+// Meant for probe-style workloads, where the same program is started over and over with different inputs.
+//
+// Memory is stored structure-of-arrays: the copies of an address in every lane are adjacent,
+// so while all lanes execute the same instruction on the same addresses, the instruction is a loop
+// over contiguous values that the compiler turns into SIMD code.
+// Lanes stay in lockstep until control flow or an address depends on a value that differs
+// between lanes. At that point every lane continues as a separate intcode_machine until reset().
+class intcode_batch
+{
+public:
+  using execution_state = intcode_machine::execution_state;
+
+  intcode_batch(intcode_program const& program, size_t num_lanes);
+
+  size_t num_lanes() const
+  {
+    return lanes;
+  }
+
+  // Puts every lane back to the start of the program with empty input and output.
+  // Costs O(addresses written since the last reset), not O(program size).
+  void reset();
+
+  void push_input(size_t lane, int64_t value);
+
+  // Same contract as intcode_machine::pop_output().
+  std::pair<bool, int64_t> pop_output(size_t lane);
+
+  execution_state get_state(size_t lane) const;
+
+  // Runs every lane until it halts or asks for input when none is provided.
+  void run();
+
+  // Whether lanes still execute together, mostly for diagnostics.
+  bool is_lockstep() const
+  {
+    return lockstep;
+  }
+
+private:
+  using arg_mode = intcode_arg_mode;
+  using operation = intcode_operation;
+
+  execution_state run_lockstep();
+  // Splits the batch into one machine per lane, at the current instruction.
+  void diverge();
+
+  // Address 'arg' of the instruction at 'ip' refers to, immediate operands refer to their own cell.
+  // Returns false if lanes disagree on it or it's out of the range kept in lockstep.
+  bool arg_address(intcode_instruction const& instr, int arg, uint64_t& address) const;
+  void ensure_rows(uint64_t address);
+  void mark_written(uint64_t address, bool is_uniform);
+
+  int64_t* row(uint64_t address)
+  {
+    return cells.data() + address * lanes;
+  }
+
+  size_t lanes;
+  intcode_program image;
+  // Source of the per-lane machines, forked after divergence.
+  intcode_machine base;
+
+  // cells[address * lanes + lane]
+  std::vector<int64_t> cells;
+  // Per address: holds the same value in every lane.
+  std::vector<uint8_t> uniform;
+  // Per address: written since the last reset.
+  std::vector<uint8_t> written;
+  std::vector<uint64_t> written_addresses;
+  // Decoded form of uniform cells, reset on every write.
+  std::vector<intcode_instruction> decoded;
+  // Same as intcode_memory::size() of a machine that executed the same writes.
+  uint64_t extent = 0;
+  uint64_t max_rows = 0;
+
+  bool lockstep = true;
+  execution_state state = execution_state::ready;
+  uint64_t ip = 0;
+  int64_t relative_base = 0;
+
+  std::vector<intcode_machine::channel> inputs;
+  std::vector<intcode_machine::channel> outputs;
+  // One per lane once lanes diverged.
+  std::vector<intcode_machine> lane_machines;
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+#include "common/intcode_machine.hpp"
+
+// Call shapes of the interpreters the early days used to carry privately, on top of intcode_machine.
+
+// Pushes 'inputs' in order and runs the machine until it halts or waits for more input.
+// Returns everything it wrote, oldest first.
+inline std::vector<int64_t> run_intcode(intcode_machine& machine, std::initializer_list<int64_t> inputs)
+{
+  for (int64_t value : inputs)
+  {
+    machine.push_input(value);
+  }
+  machine.run();
+
+  std::vector<int64_t> outputs;
+  int64_t values[64];
+  size_t count;
+  while ((count = machine.drain_outputs(values, 64)) > 0)
+  {
+    outputs.insert(outputs.end(), values, values + count);
+  }
+  return outputs;
+}
+
+// intcode_machine::pop_output() with an out parameter, returns false if there was no output.
+inline bool pop_intcode_output(intcode_machine& machine, int64_t& value)
+{
+  const std::pair<bool, int64_t> output = machine.pop_output();
+  value = output.second;
+  return output.first;
+}
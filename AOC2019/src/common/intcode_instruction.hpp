@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+
+enum class intcode_arg_mode : int8_t
+{
+  position = 0,
+  immediate = 1,
+  relative = 2,
+  invalid = -1
+};
+
+// Dense so that it can index a dispatch table.
+enum class intcode_operation : uint8_t
+{
+  undecoded = 0,
+  add,
+  multiply,
+  read_input,
+  write_output,
+  jump_if_true,
+  jump_if_false,
+  less_than,
+  equals,
+  change_relative_base,
+  halt,
+  invalid,
+  count
+};
+
+// Opcode word split into operation, operand count and operand modes.
+// Depends only on the value of the cell, so a cached entry stays valid until the cell is written.
+struct intcode_instruction
+{
+  intcode_operation op = intcode_operation::undecoded;
+  uint8_t num_args = 0;
+  intcode_arg_mode modes[3] = {};
+};
+
+inline intcode_arg_mode get_intcode_argmode(int64_t opcode, int64_t arg)
+{
+  int64_t pow = 100;
+  while (arg > 0)
+  {
+    pow *= 10;
+    arg--;
+  }
+  int64_t opmode_value = (opcode / pow) % 10;
+  switch (opmode_value)
+  {
+    case 0: return intcode_arg_mode::position;
+    case 1: return intcode_arg_mode::immediate;
+    case 2: return intcode_arg_mode::relative;
+  }
+  return intcode_arg_mode::invalid;
+}
+
+inline intcode_instruction decode_intcode_instruction(int64_t opcode)
+{
+  intcode_instruction instr;
+  switch (opcode % 100)
+  {
+    case 1: instr.op = intcode_operation::add; instr.num_args = 3; break;
+    case 2: instr.op = intcode_operation::multiply; instr.num_args = 3; break;
+    case 3: instr.op = intcode_operation::read_input; instr.num_args = 1; break;
+    case 4: instr.op = intcode_operation::write_output; instr.num_args = 1; break;
+    case 5: instr.op = intcode_operation::jump_if_true; instr.num_args = 2; break;
+    case 6: instr.op = intcode_operation::jump_if_false; instr.num_args = 2; break;
+    case 7: instr.op = intcode_operation::less_than; instr.num_args = 3; break;
+    case 8: instr.op = intcode_operation::equals; instr.num_args = 3; break;
+    case 9: instr.op = intcode_operation::change_relative_base; instr.num_args = 1; break;
+    case 99: instr.op = intcode_operation::halt; instr.num_args = 0; break;
+    default:
+    {
+      instr.op = intcode_operation::invalid;
+      return instr;
+    }
+  }
+  for (int i = 0; i < instr.num_args; i++)
+  {
+    instr.modes[i] = get_intcode_argmode(opcode, i);
+  }
+  return instr;
+}
@@ -0,0 +1,874 @@
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <mutex>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include "common/intcode_instruction.hpp"
+#include "common/intcode_jit.hpp"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define INTCODE_JIT_SUPPORTED 1
+#else
+#define INTCODE_JIT_SUPPORTED 0
+#endif
+
+namespace
+{
+  using page = intcode_memory::page;
+  using exit_reason = intcode_jit::exit_reason;
+
+  // Shared with compiled code, which addresses the fields by offset.
+  struct jit_context
+  {
+    page const* const* readable;
+    page* const* writable;
+    uint64_t directory_size;
+    uint8_t const* code_cells;
+    uint64_t code_cells_size;
+    void const* const* blocks;
+    uint64_t num_blocks;
+    void const* exit;
+    uint64_t ip;
+    int64_t relative_base;
+    uint64_t reason;
+  };
+
+#define CONTEXT_FIELD(name) ((int32_t)offsetof(jit_context, name))
+
+  static_assert(sizeof(intcode_instruction) == 5, "stores reset decoded entries with lea r, [r + r * 4]");
+  const int32_t decoded_offset = (int32_t)offsetof(page, decoded);
+
+  // Longest straight-line run compiled into one block.
+  const int max_block_instructions = 64;
+  const size_t chunk_size = 64 * 1024;
+
+  void* allocate_executable(size_t size)
+  {
+#if defined(_WIN32)
+    return VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+#else
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+#endif
+  }
+
+  void free_executable(void* p, size_t size)
+  {
+#if defined(_WIN32)
+    (void)size;
+    VirtualFree(p, 0, MEM_RELEASE);
+#else
+    munmap(p, size);
+#endif
+  }
+
+  void flush_instruction_cache(void const* p, size_t size)
+  {
+#if defined(_WIN32)
+    FlushInstructionCache(GetCurrentProcess(), p, size);
+#else
+    (void)p;
+    (void)size;
+#endif
+  }
+
+  // Standard-size chunks are recycled instead of unmapped. Machines are often short-lived forks,
+  // mapping fresh executable memory for each would cost more than running them.
+  class chunk_pool
+  {
+  public:
+    void* acquire(size_t size)
+    {
+      if (size == chunk_size)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!free_chunks.empty())
+        {
+          void* p = free_chunks.back();
+          free_chunks.pop_back();
+          return p;
+        }
+      }
+      return allocate_executable(size);
+    }
+
+    void release(void* p, size_t size)
+    {
+      if (size == chunk_size)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        free_chunks.push_back(p);
+        return;
+      }
+      free_executable(p, size);
+    }
+
+  private:
+    std::mutex mutex;
+    std::vector<void*> free_chunks;
+  };
+
+  // Never destroyed, chunks may be released by static machines during exit.
+  chunk_pool& get_chunk_pool()
+  {
+    static chunk_pool* pool = new chunk_pool;
+    return *pool;
+  }
+
+  enum reg : int
+  {
+    rax, rcx, rdx, rbx, rsp, rbp, rsi, rdi,
+    r8, r9, r10, r11, r12, r13, r14, r15
+  };
+
+  // Registers of compiled code, loaded by the entry trampoline.
+  // rax, rcx, rdx and r9-r11 are scratch.
+  const reg context_reg = r15;
+  const reg readable_reg = r12;
+  const reg writable_reg = r13;
+  const reg relative_base_reg = r14;
+  const reg blocks_reg = rbx;
+  const reg code_cells_reg = rbp;
+
+  enum condition : uint8_t
+  {
+    cc_b = 0x2,
+    cc_ae = 0x3,
+    cc_z = 0x4,
+    cc_nz = 0x5,
+    cc_be = 0x6,
+    cc_l = 0xC
+  };
+
+  // Just the instruction forms the compiler needs. Memory operands always use a 32-bit displacement.
+  class x64_assembler
+  {
+  public:
+    std::vector<uint8_t> code;
+
+    void emit(uint8_t b)
+    {
+      code.push_back(b);
+    }
+
+    void emit32(uint32_t v)
+    {
+      for (int i = 0; i < 4; i++)
+      {
+        emit((uint8_t)(v >> (8 * i)));
+      }
+    }
+
+    void emit64(uint64_t v)
+    {
+      for (int i = 0; i < 8; i++)
+      {
+        emit((uint8_t)(v >> (8 * i)));
+      }
+    }
+
+    // Operand [base + index * (1 << scale) + disp], no index if index < 0.
+    void mem_op(bool wide, std::initializer_list<uint8_t> opcode, int reg_field, int base, int index, int scale, int32_t disp)
+    {
+      const uint8_t rex = 0x40 | (wide ? 8 : 0) | ((reg_field & 8) ? 4 : 0) | ((index >= 0 && (index & 8)) ? 2 : 0) | ((base & 8) ? 1 : 0);
+      if (rex != 0x40)
+      {
+        emit(rex);
+      }
+      for (uint8_t b : opcode)
+      {
+        emit(b);
+      }
+      if (index < 0 && (base & 7) != rsp)
+      {
+        emit((uint8_t)(0x80 | ((reg_field & 7) << 3) | (base & 7)));
+      }
+      else
+      {
+        emit((uint8_t)(0x80 | ((reg_field & 7) << 3) | 4));
+        emit((uint8_t)((scale << 6) | (((index < 0 ? rsp : index) & 7) << 3) | (base & 7)));
+      }
+      emit32((uint32_t)disp);
+    }
+
+    void reg_op(bool wide, std::initializer_list<uint8_t> opcode, int reg_field, int rm)
+    {
+      const uint8_t rex = 0x40 | (wide ? 8 : 0) | ((reg_field & 8) ? 4 : 0) | ((rm & 8) ? 1 : 0);
+      if (rex != 0x40)
+      {
+        emit(rex);
+      }
+      for (uint8_t b : opcode)
+      {
+        emit(b);
+      }
+      emit((uint8_t)(0xC0 | ((reg_field & 7) << 3) | (rm & 7)));
+    }
+
+    void mov_imm(int r, int64_t v)
+    {
+      if (v == (int32_t)v)
+      {
+        reg_op(true, { 0xC7 }, 0, r);
+        emit32((uint32_t)v);
+      }
+      else
+      {
+        emit((uint8_t)(0x48 | ((r & 8) ? 1 : 0)));
+        emit((uint8_t)(0xB8 + (r & 7)));
+        emit64((uint64_t)v);
+      }
+    }
+
+    void load(int dst, int base, int index, int scale, int32_t disp)
+    {
+      mem_op(true, { 0x8B }, dst, base, index, scale, disp);
+    }
+
+    void store(int base, int index, int scale, int32_t disp, int src)
+    {
+      mem_op(true, { 0x89 }, src, base, index, scale, disp);
+    }
+
+    void store_byte_zero(int base, int index, int32_t disp)
+    {
+      mem_op(false, { 0xC6 }, 0, base, index, 0, disp);
+      emit(0);
+    }
+
+    void cmp_byte_zero(int base, int index, int32_t disp)
+    {
+      mem_op(false, { 0x80 }, 7, base, index, 0, disp);
+      emit(0);
+    }
+
+    // Flags of [base + disp] - imm.
+    void cmp_mem_imm(int base, int32_t disp, int32_t imm)
+    {
+      mem_op(true, { 0x81 }, 7, base, -1, 0, disp);
+      emit32((uint32_t)imm);
+    }
+
+    // Flags of r - [base + disp].
+    void cmp_reg_mem(int r, int base, int32_t disp)
+    {
+      mem_op(true, { 0x3B }, r, base, -1, 0, disp);
+    }
+
+    void lea(int dst, int base, int index, int scale, int32_t disp)
+    {
+      mem_op(true, { 0x8D }, dst, base, index, scale, disp);
+    }
+
+    void mov(int dst, int src)
+    {
+      reg_op(true, { 0x89 }, src, dst);
+    }
+
+    void add(int dst, int src)
+    {
+      reg_op(true, { 0x01 }, src, dst);
+    }
+
+    void imul(int dst, int src)
+    {
+      reg_op(true, { 0x0F, 0xAF }, dst, src);
+    }
+
+    // Flags of a - b.
+    void cmp(int a, int b)
+    {
+      reg_op(true, { 0x39 }, b, a);
+    }
+
+    void test(int a, int b)
+    {
+      reg_op(true, { 0x85 }, b, a);
+    }
+
+    void shr(int r, uint8_t n)
+    {
+      reg_op(true, { 0xC1 }, 5, r);
+      emit(n);
+    }
+
+    void and_imm(int r, int32_t imm)
+    {
+      reg_op(true, { 0x81 }, 4, r);
+      emit32((uint32_t)imm);
+    }
+
+    // r = condition ? 1 : 0, for r in rax..rbx.
+    void set(condition cc, int r)
+    {
+      reg_op(false, { 0x0F, (uint8_t)(0x90 | cc) }, 0, r);
+      reg_op(false, { 0x0F, 0xB6 }, r, r);
+    }
+
+    void jmp_reg(int r)
+    {
+      reg_op(false, { 0xFF }, 4, r);
+    }
+
+    void jmp_mem(int base, int32_t disp)
+    {
+      mem_op(false, { 0xFF }, 4, base, -1, 0, disp);
+    }
+
+    void push(int r)
+    {
+      if (r & 8)
+      {
+        emit(0x41);
+      }
+      emit((uint8_t)(0x50 + (r & 7)));
+    }
+
+    void pop(int r)
+    {
+      if (r & 8)
+      {
+        emit(0x41);
+      }
+      emit((uint8_t)(0x58 + (r & 7)));
+    }
+
+    void ret()
+    {
+      emit(0xC3);
+    }
+
+    // Forward jumps, return the position to pass to bind().
+    size_t jcc(condition cc)
+    {
+      emit(0x0F);
+      emit((uint8_t)(0x80 | cc));
+      emit32(0);
+      return code.size();
+    }
+
+    size_t jmp()
+    {
+      emit(0xE9);
+      emit32(0);
+      return code.size();
+    }
+
+    // Points the jump ending at 'jump_end' to the current position.
+    void bind(size_t jump_end)
+    {
+      const uint32_t rel = (uint32_t)(code.size() - jump_end);
+      for (int i = 0; i < 4; i++)
+      {
+        code[jump_end - 4 + i] = (uint8_t)(rel >> (8 * i));
+      }
+    }
+  };
+
+  struct trampolines
+  {
+    // Loads the registers of compiled code from the context and jumps to 'block'.
+    void (*enter)(jit_context* context, void const* block);
+    // Stores ip (rax), reason (rcx) and relative base into the context and returns from enter().
+    void const* exit;
+  };
+
+  trampolines build_trampolines()
+  {
+    static const reg saved[] = { rbx, rbp, rsi, rdi, r12, r13, r14, r15 };
+#if defined(_WIN32)
+    const reg arg0 = rcx;
+    const reg arg1 = rdx;
+#else
+    const reg arg0 = rdi;
+    const reg arg1 = rsi;
+#endif
+    x64_assembler a;
+    for (reg r : saved)
+    {
+      a.push(r);
+    }
+    a.mov(context_reg, arg0);
+    a.mov(r11, arg1);
+    a.load(readable_reg, context_reg, -1, 0, CONTEXT_FIELD(readable));
+    a.load(writable_reg, context_reg, -1, 0, CONTEXT_FIELD(writable));
+    a.load(code_cells_reg, context_reg, -1, 0, CONTEXT_FIELD(code_cells));
+    a.load(blocks_reg, context_reg, -1, 0, CONTEXT_FIELD(blocks));
+    a.load(relative_base_reg, context_reg, -1, 0, CONTEXT_FIELD(relative_base));
+    a.jmp_reg(r11);
+
+    const size_t exit_offset = a.code.size();
+    a.store(context_reg, -1, 0, CONTEXT_FIELD(ip), rax);
+    a.store(context_reg, -1, 0, CONTEXT_FIELD(reason), rcx);
+    a.store(context_reg, -1, 0, CONTEXT_FIELD(relative_base), relative_base_reg);
+    for (int i = (int)(sizeof(saved) / sizeof(saved[0])) - 1; i >= 0; i--)
+    {
+      a.pop(saved[i]);
+    }
+    a.ret();
+
+    trampolines ret = { nullptr, nullptr };
+    uint8_t* p = (uint8_t*)allocate_executable(a.code.size());
+    if (p != nullptr)
+    {
+      memcpy(p, a.code.data(), a.code.size());
+      flush_instruction_cache(p, a.code.size());
+      ret.enter = (void (*)(jit_context*, void const*))p;
+      ret.exit = p + exit_offset;
+    }
+    return ret;
+  }
+
+  // Built once, never freed.
+  trampolines const* get_trampolines()
+  {
+#if INTCODE_JIT_SUPPORTED
+    static const trampolines t = build_trampolines();
+    return t.enter != nullptr ? &t : nullptr;
+#else
+    return nullptr;
+#endif
+  }
+
+  bool requested_by_environment()
+  {
+    const char* value = getenv("INTCODE_JIT");
+    return value != nullptr && *value != '\0' && strcmp(value, "0") != 0;
+  }
+
+  std::atomic<bool>& jit_enabled()
+  {
+    static std::atomic<bool> enabled{ requested_by_environment() };
+    return enabled;
+  }
+
+  // Compiles one block: instructions from the entry up to the first jump, or up to an
+  // instruction that needs the interpreter. Checks that can fail (missing pages, bounds)
+  // jump to exit stubs emitted after the body, before the instruction has any effect.
+  class block_compiler
+  {
+  public:
+    block_compiler(intcode_memory const& memory, uint64_t num_blocks, std::vector<uint8_t>& code_cells)
+      : memory(memory)
+      , num_blocks(num_blocks)
+      , code_cells(code_cells)
+    {
+    }
+
+    std::vector<uint8_t> const& compile(uint64_t entry)
+    {
+      uint64_t ip = entry;
+      for (int count = 0; ; count++)
+      {
+        if (count == max_block_instructions)
+        {
+          emit_goto(ip);
+          break;
+        }
+        const intcode_instruction instr = decode_intcode_instruction(memory.read(ip));
+        if (!is_compilable(instr, ip))
+        {
+          emit_exit(ip, exit_reason::step);
+          break;
+        }
+        for (uint64_t i = 0; i <= instr.num_args; i++)
+        {
+          code_cells[ip + i] = 1;
+        }
+        if (!compile_instruction(instr, ip))
+        {
+          break;
+        }
+        ip += 1 + instr.num_args;
+      }
+      emit_stubs();
+      return a.code;
+    }
+
+  private:
+    struct stub
+    {
+      uint64_t ip;
+      exit_reason reason;
+      std::vector<size_t> jumps;
+    };
+
+    bool is_compilable(intcode_instruction const& instr, uint64_t ip) const
+    {
+      switch (instr.op)
+      {
+        case intcode_operation::read_input:
+        case intcode_operation::write_output:
+        case intcode_operation::halt:
+        case intcode_operation::invalid:
+        case intcode_operation::undecoded:
+          return false;
+        default:
+          break;
+      }
+      for (int i = 0; i < instr.num_args; i++)
+      {
+        if (instr.modes[i] == intcode_arg_mode::invalid)
+        {
+          return false;
+        }
+      }
+      return ip + instr.num_args < code_cells.size();
+    }
+
+    int64_t cell(uint64_t ip, int arg) const
+    {
+      return memory.read(ip + 1 + arg);
+    }
+
+    // Returns false if the instruction ends the block.
+    bool compile_instruction(intcode_instruction const& instr, uint64_t ip)
+    {
+      const uint64_t next = ip + 1 + instr.num_args;
+      switch (instr.op)
+      {
+        case intcode_operation::add:
+        case intcode_operation::multiply:
+        case intcode_operation::less_than:
+        case intcode_operation::equals:
+          load_operand(rax, instr, ip, 0);
+          load_operand(rcx, instr, ip, 1);
+          if (instr.op == intcode_operation::add)
+          {
+            a.add(rax, rcx);
+          }
+          else if (instr.op == intcode_operation::multiply)
+          {
+            a.imul(rax, rcx);
+          }
+          else
+          {
+            a.cmp(rax, rcx);
+            a.set(instr.op == intcode_operation::less_than ? cc_l : cc_z, rax);
+          }
+          store_result(instr, ip, 2, next);
+          return true;
+        case intcode_operation::change_relative_base:
+          load_operand(rax, instr, ip, 0);
+          a.add(relative_base_reg, rax);
+          return true;
+        case intcode_operation::jump_if_true:
+        case intcode_operation::jump_if_false:
+        {
+          load_operand(rax, instr, ip, 0);
+          a.test(rax, rax);
+          const size_t not_taken = a.jcc(instr.op == intcode_operation::jump_if_true ? cc_z : cc_nz);
+          if (instr.modes[1] == intcode_arg_mode::immediate)
+          {
+            emit_goto((uint64_t)cell(ip, 1));
+          }
+          else
+          {
+            load_operand(rcx, instr, ip, 1);
+            emit_goto_dynamic();
+          }
+          a.bind(not_taken);
+          emit_goto(next);
+          return false;
+        }
+        default:
+          emit_exit(ip, exit_reason::step);
+          return false;
+      }
+    }
+
+    void exit_on(size_t jump, uint64_t ip, exit_reason reason)
+    {
+      for (stub& s : stubs)
+      {
+        if (s.ip == ip && s.reason == reason)
+        {
+          s.jumps.push_back(jump);
+          return;
+        }
+      }
+      stubs.push_back({ ip, reason, { jump } });
+    }
+
+    void emit_exit(uint64_t ip, exit_reason reason)
+    {
+      a.mov_imm(rax, (int64_t)ip);
+      a.mov_imm(rcx, (int64_t)reason);
+      a.jmp_mem(context_reg, CONTEXT_FIELD(exit));
+    }
+
+    void emit_stubs()
+    {
+      for (stub const& s : stubs)
+      {
+        for (size_t jump : s.jumps)
+        {
+          a.bind(jump);
+        }
+        emit_exit(s.ip, s.reason);
+      }
+    }
+
+    // r10 = page of constant 'address' from 'table', exits to the interpreter if it's not there.
+    void load_page(uint64_t address, reg table, uint64_t ip)
+    {
+      const uint64_t index = address >> intcode_memory::page_bits;
+      if (index >= intcode_memory::directory_limit)
+      {
+        exit_on(a.jmp(), ip, exit_reason::step);
+        return;
+      }
+      a.cmp_mem_imm(context_reg, CONTEXT_FIELD(directory_size), (int32_t)index);
+      exit_on(a.jcc(cc_be), ip, exit_reason::step);
+      a.load(r10, table, -1, 0, (int32_t)(index * 8));
+      a.test(r10, r10);
+      exit_on(a.jcc(cc_z), ip, exit_reason::step);
+    }
+
+    // r9 = relative base + offset, r10 = its page from 'table', exits to the interpreter if it's not there.
+    void load_relative_page(int64_t offset, reg table, uint64_t ip)
+    {
+      if (offset == (int32_t)offset)
+      {
+        a.lea(r9, relative_base_reg, -1, 0, (int32_t)offset);
+      }
+      else
+      {
+        a.mov_imm(r9, offset);
+        a.add(r9, relative_base_reg);
+      }
+      a.mov(r10, r9);
+      a.shr(r10, (uint8_t)intcode_memory::page_bits);
+      a.cmp_reg_mem(r10, context_reg, CONTEXT_FIELD(directory_size));
+      exit_on(a.jcc(cc_ae), ip, exit_reason::step);
+      a.load(r10, table, r10, 3, 0);
+      a.test(r10, r10);
+      exit_on(a.jcc(cc_z), ip, exit_reason::step);
+    }
+
+    void load_operand(reg dst, intcode_instruction const& instr, uint64_t ip, int arg)
+    {
+      const int64_t value = cell(ip, arg);
+      switch (instr.modes[arg])
+      {
+        case intcode_arg_mode::immediate:
+          a.mov_imm(dst, value);
+          break;
+        case intcode_arg_mode::position:
+        {
+          const uint64_t address = (uint64_t)value;
+          load_page(address, readable_reg, ip);
+          a.load(dst, r10, -1, 0, (int32_t)((address & intcode_memory::page_mask) * 8));
+        }
+        break;
+        case intcode_arg_mode::relative:
+        default:
+          load_relative_page(value, readable_reg, ip);
+          a.and_imm(r9, (int32_t)intcode_memory::page_mask);
+          a.load(dst, r10, r9, 3, 0);
+          break;
+      }
+    }
+
+    // Stores rax like intcode_memory::write(), then leaves with 'invalidated' if the cell was compiled code.
+    void store_result(intcode_instruction const& instr, uint64_t ip, int arg, uint64_t next)
+    {
+      uint64_t address = ip + 1 + arg;
+      switch (instr.modes[arg])
+      {
+        case intcode_arg_mode::position:
+          address = (uint64_t)cell(ip, arg);
+          // fallthrough
+        case intcode_arg_mode::immediate:
+        {
+          load_page(address, writable_reg, ip);
+          const uint64_t offset = address & intcode_memory::page_mask;
+          a.store(r10, -1, 0, (int32_t)(offset * 8), rax);
+          a.store_byte_zero(r10, -1, decoded_offset + (int32_t)(offset * sizeof(intcode_instruction)));
+          if (address < intcode_memory::directory_limit * intcode_memory::page_size)
+          {
+            a.cmp_mem_imm(context_reg, CONTEXT_FIELD(code_cells_size), (int32_t)address);
+            const size_t not_code = a.jcc(cc_be);
+            a.cmp_byte_zero(code_cells_reg, -1, (int32_t)address);
+            exit_on(a.jcc(cc_nz), next, exit_reason::invalidated);
+            a.bind(not_code);
+          }
+        }
+        break;
+        case intcode_arg_mode::relative:
+        default:
+        {
+          load_relative_page(cell(ip, arg), writable_reg, ip);
+          a.mov(r11, r9);
+          a.and_imm(r11, (int32_t)intcode_memory::page_mask);
+          a.store(r10, r11, 3, 0, rax);
+          a.lea(r11, r11, r11, 2, 0);
+          a.store_byte_zero(r10, r11, decoded_offset);
+          a.cmp_reg_mem(r9, context_reg, CONTEXT_FIELD(code_cells_size));
+          const size_t not_code = a.jcc(cc_ae);
+          a.cmp_byte_zero(code_cells_reg, r9, 0);
+          exit_on(a.jcc(cc_nz), next, exit_reason::invalidated);
+          a.bind(not_code);
+        }
+        break;
+      }
+    }
+
+    // Continues at the block for 'target' if it's compiled, leaves to compile it otherwise.
+    void emit_goto(uint64_t target)
+    {
+      if (target >= num_blocks)
+      {
+        emit_exit(target, exit_reason::lookup);
+        return;
+      }
+      a.load(rdx, blocks_reg, -1, 0, (int32_t)(target * 8));
+      a.test(rdx, rdx);
+      exit_on(a.jcc(cc_z), target, exit_reason::lookup);
+      a.jmp_reg(rdx);
+    }
+
+    // Same as emit_goto() for a target in rcx.
+    void emit_goto_dynamic()
+    {
+      a.cmp_reg_mem(rcx, context_reg, CONTEXT_FIELD(num_blocks));
+      const size_t out_of_range = a.jcc(cc_ae);
+      a.load(rdx, blocks_reg, rcx, 3, 0);
+      a.test(rdx, rdx);
+      const size_t not_compiled = a.jcc(cc_z);
+      a.jmp_reg(rdx);
+      a.bind(out_of_range);
+      a.bind(not_compiled);
+      a.mov(rax, rcx);
+      a.mov_imm(rcx, (int64_t)exit_reason::lookup);
+      a.jmp_mem(context_reg, CONTEXT_FIELD(exit));
+    }
+
+    intcode_memory const& memory;
+    uint64_t num_blocks;
+    std::vector<uint8_t>& code_cells;
+    x64_assembler a;
+    std::vector<stub> stubs;
+  };
+}
+
+struct intcode_jit::code_chunk
+{
+  uint8_t* memory = nullptr;
+  size_t capacity = 0;
+  size_t used = 0;
+
+  explicit code_chunk(size_t size)
+  {
+    memory = (uint8_t*)get_chunk_pool().acquire(size);
+    capacity = memory != nullptr ? size : 0;
+  }
+
+  ~code_chunk()
+  {
+    if (memory != nullptr)
+    {
+      get_chunk_pool().release(memory, capacity);
+    }
+  }
+
+  code_chunk(code_chunk const&) = delete;
+  code_chunk& operator=(code_chunk const&) = delete;
+};
+
+bool intcode_jit::is_enabled()
+{
+  return jit_enabled().load(std::memory_order_relaxed) && get_trampolines() != nullptr;
+}
+
+void intcode_jit::set_enabled(bool enabled)
+{
+  jit_enabled().store(enabled, std::memory_order_relaxed);
+}
+
+intcode_jit::intcode_jit(uint64_t code_size)
+{
+  code_size = std::min<uint64_t>(code_size, intcode_memory::directory_limit * intcode_memory::page_size);
+  blocks.resize(code_size, nullptr);
+  code_cells.resize(code_size, 0);
+}
+
+intcode_jit::exit_reason intcode_jit::run(intcode_memory& memory, uint64_t& ip, int64_t& relative_base)
+{
+  trampolines const* t = get_trampolines();
+  jit_context context;
+  context.readable = memory.readable_data();
+  context.writable = memory.writable_data();
+  context.directory_size = memory.directory_size();
+  context.code_cells = code_cells.data();
+  context.code_cells_size = code_cells.size();
+  context.blocks = blocks.data();
+  context.num_blocks = blocks.size();
+  context.exit = t->exit;
+  context.ip = ip;
+  context.relative_base = relative_base;
+  context.reason = (uint64_t)exit_reason::lookup;
+
+  while ((exit_reason)context.reason == exit_reason::lookup)
+  {
+    if (context.ip >= blocks.size())
+    {
+      context.reason = (uint64_t)exit_reason::step;
+      break;
+    }
+    void const* block = blocks[context.ip];
+    if (block == nullptr)
+    {
+      block = compile(memory, context.ip);
+      if (block == nullptr)
+      {
+        context.reason = (uint64_t)exit_reason::step;
+        break;
+      }
+    }
+    t->enter(&context, block);
+  }
+
+  ip = context.ip;
+  relative_base = context.relative_base;
+  return (exit_reason)context.reason;
+}
+
+void const* intcode_jit::compile(intcode_memory const& memory, uint64_t ip)
+{
+  block_compiler compiler(memory, blocks.size(), code_cells);
+  void const* block = place(compiler.compile(ip));
+  blocks[ip] = block;
+  return block;
+}
+
+// Chunks shared with other caches are never appended to, so each cache writes only its own memory.
+void const* intcode_jit::place(std::vector<uint8_t> const& code)
+{
+  if (chunks.empty() || chunks.back().use_count() > 1 || chunks.back()->capacity - chunks.back()->used < code.size())
+  {
+    chunks.push_back(std::make_shared<code_chunk>(std::max(chunk_size, code.size())));
+  }
+  code_chunk& chunk = *chunks.back();
+  if (chunk.memory == nullptr)
+  {
+    chunks.pop_back();
+    return nullptr;
+  }
+  uint8_t* p = chunk.memory + chunk.used;
+  memcpy(p, code.data(), code.size());
+  flush_instruction_cache(p, code.size());
+  chunk.used += code.size();
+  return p;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "common/intcode_memory.hpp"
+
+// Optional x86-64 backend of intcode_machine::run().
+// Basic blocks are compiled to native code on first execution and cached by entry ip.
+// Compiled code works directly on the pages of intcode_memory; blocks jump to each other
+// through the cache without returning, as long as the target is already compiled.
+// Everything unusual is left to the interpreter one instruction at a time: input/output,
+// halting, missing or shared pages, far addresses.
+//
+// A cache belongs to one machine state. Forked machines share it copy-on-write, and any write
+// into a compiled instruction throws the cache away (see intcode_machine::write_memory()).
+class intcode_jit
+{
+public:
+  enum class exit_reason : uint64_t
+  {
+    // 'ip' has no compiled block yet. Internal, run() handles it.
+    lookup = 0,
+    // The interpreter has to execute the instruction at 'ip'.
+    step = 1,
+    // The last instruction wrote into compiled code, the cache is no longer valid.
+    invalidated = 2
+  };
+
+  // Whether machines use the JIT. Off by default, unless the INTCODE_JIT environment variable is set
+  // to something other than 0. Always false on platforms without the backend.
+  static bool is_enabled();
+  static void set_enabled(bool enabled);
+
+  // 'code_size' bounds the addresses blocks can start at, normally the size of the program image.
+  explicit intcode_jit(uint64_t code_size);
+
+  // Runs compiled code from 'ip' until it needs the interpreter.
+  exit_reason run(intcode_memory& memory, uint64_t& ip, int64_t& relative_base);
+
+  // Whether 'address' belongs to a compiled instruction.
+  bool is_translated(uint64_t address) const
+  {
+    return address < code_cells.size() && code_cells[address] != 0;
+  }
+
+  struct code_chunk;
+
+private:
+  void const* compile(intcode_memory const& memory, uint64_t ip);
+  void const* place(std::vector<uint8_t> const& code);
+
+  // Entry points by ip, nullptr where nothing is compiled yet.
+  std::vector<void const*> blocks;
+  std::vector<uint8_t> code_cells;
+  // Executable memory holding the blocks, shared with copies of the cache.
+  std::vector<std::shared_ptr<code_chunk>> chunks;
+};
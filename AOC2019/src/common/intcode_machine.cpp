@@ -1,38 +1,200 @@
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 
 #include "common/intcode_machine.hpp"
+#include "parse_cache.hpp"
 
-intcode_machine::intcode_machine(intcode_program const & program) : program(program)
+// Threaded dispatch of run() relies on labels as values, which are a GCC/Clang extension.
+// Define to 0 to build the portable switch-based loop instead.
+#ifndef INTCODE_THREADED_DISPATCH
+#if defined(__GNUC__) || defined(__clang__)
+#define INTCODE_THREADED_DISPATCH 1
+#else
+#define INTCODE_THREADED_DISPATCH 0
+#endif
+#endif
+
+namespace
+{
+  // Programs that keep rewriting compiled code give up on the JIT after this many cache flushes.
+  const uint32_t max_jit_invalidations = 16;
+  // Instructions a machine interprets before it gets a JIT cache. Short-lived forks
+  // finish long before compiling anything would pay off.
+  const uint32_t jit_warmup_steps = 256;
+}
+
+intcode_machine::intcode_machine(intcode_program const & program)
+  : program(program)
+  , native(find_intcode_native_program(program))
+{
+}
+
+intcode_machine::intcode_machine(intcode_memory&& memory) : program(std::move(memory))
+{
+}
+
+intcode_machine::intcode_machine(intcode_machine const& other)
+  : program(other.program)
+  , input(other.input)
+  , output(other.output)
+  , state(other.state)
+  , ip(other.ip)
+  , relative_base(other.relative_base)
+  , native(other.native)
+  , jit(other.jit)
+  , jit_invalidations(other.jit_invalidations)
+  , jit_warmup(other.jit_warmup)
+{
+}
+
+intcode_machine::intcode_machine(intcode_machine&& other)
+  : program(std::move(other.program))
+  , input(std::move(other.input))
+  , output(std::move(other.output))
+  , state(other.state)
+  , ip(other.ip)
+  , relative_base(other.relative_base)
+  , native(other.native)
+  , jit(other.jit)
+  , jit_invalidations(other.jit_invalidations)
+  , jit_warmup(other.jit_warmup)
+{
+}
+
+intcode_machine& intcode_machine::operator=(intcode_machine const& other)
+{
+  program = other.program;
+  input = other.input;
+  output = other.output;
+  output_target = &output;
+  state = other.state;
+  ip = other.ip;
+  relative_base = other.relative_base;
+  native = other.native;
+  jit = other.jit;
+  jit_invalidations = other.jit_invalidations;
+  jit_warmup = other.jit_warmup;
+  return *this;
+}
+
+intcode_machine& intcode_machine::operator=(intcode_machine&& other)
 {
+  program = std::move(other.program);
+  input = std::move(other.input);
+  output = std::move(other.output);
+  output_target = &output;
+  state = other.state;
+  ip = other.ip;
+  relative_base = other.relative_base;
+  native = other.native;
+  jit = other.jit;
+  jit_invalidations = other.jit_invalidations;
+  jit_warmup = other.jit_warmup;
+  return *this;
+}
+
+intcode_machine intcode_machine::fork()
+{
+  intcode_machine ret{ program.share() };
+  ret.input = input;
+  ret.output = output;
+  ret.state = state;
+  ret.ip = ip;
+  ret.relative_base = relative_base;
+  ret.native = native;
+  ret.jit = jit;
+  ret.jit_invalidations = jit_invalidations;
+  ret.jit_warmup = jit_warmup;
+  return ret;
+}
+
+intcode_machine::snapshot intcode_machine::save()
+{
+  snapshot ret;
+  ret.program = program.share();
+  ret.input = input;
+  ret.output = output;
+  ret.state = state;
+  ret.ip = ip;
+  ret.relative_base = relative_base;
+  ret.native = native;
+  ret.jit = jit;
+  ret.jit_invalidations = jit_invalidations;
+  ret.jit_warmup = jit_warmup;
+  return ret;
+}
+
+void intcode_machine::restore(snapshot const& s)
+{
+  program = s.program.share_unowned();
+  input = s.input;
+  output = s.output;
+  state = s.state;
+  ip = s.ip;
+  relative_base = s.relative_base;
+  native = s.native;
+  jit = s.jit;
+  jit_invalidations = s.jit_invalidations;
+  jit_warmup = s.jit_warmup;
 }
 
 void intcode_machine::modify_program(uint64_t address, int64_t value)
 {
   if (address < program.size())
   {
-    program[address] = value;
+    write_memory(address, value);
+    if (native != nullptr && native->is_translated(address))
+    {
+      native = nullptr;
+    }
+  }
+}
+
+void intcode_machine::write_memory(uint64_t address, int64_t value)
+{
+  program.write(address, value);
+  if (jit != nullptr && jit->is_translated(address))
+  {
+    jit.reset();
   }
 }
 
-void intcode_machine::push_input(int64_t value)
+bool intcode_machine::push_input(int64_t value)
 {
-  input.push(value);
+  return input.push(value);
+}
+
+size_t intcode_machine::push_inputs(int64_t const* values, size_t count)
+{
+  return input.push_bulk(values, count);
 }
 
 std::pair<bool, int64_t> intcode_machine::pop_output()
 {
-  if (output.size() > 0)
+  int64_t value = 0;
+  if (output.pop(value))
   {
-    int64_t value = output.front();
-    output.pop();
     return {true, value};
   }
   return {false, 0};
 }
 
+size_t intcode_machine::drain_outputs(int64_t* values, size_t max_count)
+{
+  return output.pop_bulk(values, max_count);
+}
+
+void intcode_machine::connect_output(intcode_machine& consumer, size_t capacity)
+{
+  consumer.input.reserve(capacity);
+  consumer.input.set_growable(false);
+  output_target = &consumer.input;
+}
+
 intcode_machine::execution_state intcode_machine::single_step()
 {
-  if (state != execution_state::ready && state != execution_state::awaiting_input)
+  if (!is_valid_state(state))
   {
     return state;
   }
@@ -43,124 +205,132 @@ intcode_machine::execution_state intcode_machine::single_step()
     return state;
   }
 
-  uint64_t pos[4];
-  auto fetch_arg_positions = [this, &pos](int num_args) -> bool
+  decoded_instruction const instr = program.instruction_at(ip);
+  uint64_t pos[3];
+  auto fetch_arg_positions = [this, &instr, &pos]() -> bool
   {
     bool pos_valid = true;
-    for (int i = 0; i < num_args; i++)
+    for (int i = 0; i < instr.num_args; i++)
     {
-      pos[i] = arg_position(i);
-      if (pos[i] == (uint64_t)-1 || pos[i] >= program.size())
+      pos[i] = arg_position(instr, i);
+      if (pos[i] == (uint64_t)-1)
       {
         pos_valid = false;
       }
     }
     return pos_valid;
   };
+  auto store = [this](uint64_t address, int64_t value)
+  {
+    write_memory(address, value);
+  };
 
-  int64_t opcode_value = program[ip] % 100;
-  switch (opcode_value)
+  switch (instr.op)
   {
     // Add
-    case 1:
+    case operation::add:
     {
-      if (fetch_arg_positions(3))
+      if (fetch_arg_positions())
       {
-        program[pos[2]] = program[pos[0]] + program[pos[1]];
+        store(pos[2], program.read(pos[0]) + program.read(pos[1]));
         ip += 4;
       }
     }
     break;
     // Multiply
-    case 2:
+    case operation::multiply:
     {
-      if (fetch_arg_positions(3))
+      if (fetch_arg_positions())
       {
-        program[pos[2]] = program[pos[0]] * program[pos[1]];
+        store(pos[2], program.read(pos[0]) * program.read(pos[1]));
         ip += 4;
       }
     }
     break;
     // Read input
-    case 3:
+    case operation::read_input:
     {
-      if (input.size() == 0)
+      int64_t value = 0;
+      if (input.empty())
       {
         state = execution_state::awaiting_input;
       }
-      else if (fetch_arg_positions(1))
+      else if (fetch_arg_positions() && input.pop(value))
       {
-        program[pos[0]] = input.front();
-        input.pop();
+        store(pos[0], value);
         ip += 2;
       }
     }
     break;
     // Write output
-    case 4:
+    case operation::write_output:
     {
-      if (fetch_arg_positions(1))
+      if (!output_target->can_push())
+      {
+        state = execution_state::awaiting_output;
+      }
+      else if (fetch_arg_positions() && output_target->push(program.read(pos[0])))
       {
-        output.push(program[pos[0]]);
         ip += 2;
       }
     }
     break;
     // Jump if true
-    case 5:
+    case operation::jump_if_true:
     {
-      if (fetch_arg_positions(2))
+      if (fetch_arg_positions())
       {
-        ip = (program[pos[0]] != 0) ? program[pos[1]] : ip + 3;
+        ip = (program.read(pos[0]) != 0) ? program.read(pos[1]) : ip + 3;
       }
     }
     break;
     // Jump if false
-    case 6:
+    case operation::jump_if_false:
     {
-      if (fetch_arg_positions(2))
+      if (fetch_arg_positions())
       {
-        ip = (program[pos[0]] == 0) ? program[pos[1]] : ip + 3;
+        ip = (program.read(pos[0]) == 0) ? program.read(pos[1]) : ip + 3;
       }
     }
     break;
     // Less than
-    case 7:
+    case operation::less_than:
     {
-      if (fetch_arg_positions(3))
+      if (fetch_arg_positions())
       {
-        program[pos[2]] = program[pos[0]] < program[pos[1]] ? 1 : 0;
+        store(pos[2], program.read(pos[0]) < program.read(pos[1]) ? 1 : 0);
         ip += 4;
       }
     }
     break;
     // Equals
-    case 8:
+    case operation::equals:
     {
-      if (fetch_arg_positions(3))
+      if (fetch_arg_positions())
       {
-        program[pos[2]] = program[pos[0]] == program[pos[1]] ? 1 : 0;
+        store(pos[2], program.read(pos[0]) == program.read(pos[1]) ? 1 : 0);
         ip += 4;
       }
     }
     break;
     // Change relative base
-    case 9:
+    case operation::change_relative_base:
     {
-      if (fetch_arg_positions(1))
+      if (fetch_arg_positions())
       {
-        relative_base += program[pos[0]];
+        relative_base += program.read(pos[0]);
         ip += 2;
       }
     }
     break;
     // Halt
-    case 99:
+    case operation::halt:
     {
       state = execution_state::halted;
     }
     break;
     // Unknown code
+    case operation::invalid:
     default:
     {
       state = execution_state::invalid_op;
@@ -173,50 +343,360 @@ intcode_machine::execution_state intcode_machine::single_step()
 
 intcode_machine::execution_state intcode_machine::run()
 {
-  if (state == execution_state::awaiting_input && input.size() > 0)
+  if ((state == execution_state::awaiting_input && !input.empty()) ||
+      (state == execution_state::awaiting_output && output_target->can_push()))
   {
     state = execution_state::ready;
   }
 
-  while (state == execution_state::ready)
+  if (state == execution_state::ready && native != nullptr)
+  {
+    state = run_native();
+  }
+
+  if (state == execution_state::ready && jit_invalidations < max_jit_invalidations && intcode_jit::is_enabled())
+  {
+    state = run_jit();
+  }
+
+  if (state == execution_state::ready)
   {
-    state = single_step();
+    // The fast loop doesn't check its writes against compiled code.
+    jit.reset();
+    state = run_fast();
   }
 
   return state;
 }
 
-intcode_machine::arg_mode intcode_machine::get_argmode(int64_t opcode, int64_t arg)
+intcode_machine::execution_state intcode_machine::run_jit()
+{
+  for (;;)
+  {
+    if (jit == nullptr && jit_warmup < jit_warmup_steps)
+    {
+      jit_warmup++;
+    }
+    else
+    {
+      if (jit == nullptr)
+      {
+        jit = std::make_shared<intcode_jit>(program.size());
+      }
+      else if (jit.use_count() > 1)
+      {
+        jit = std::make_shared<intcode_jit>(*jit);
+      }
+
+      if (jit->run(program, ip, relative_base) == intcode_jit::exit_reason::invalidated)
+      {
+        jit.reset();
+        if (++jit_invalidations == max_jit_invalidations)
+        {
+          return execution_state::ready;
+        }
+        continue;
+      }
+    }
+
+    // Instructions compiled code leaves to the interpreter: I/O, halting, unusual memory accesses.
+    const execution_state s = single_step();
+    if (s != execution_state::ready)
+    {
+      return s;
+    }
+  }
+}
+
+intcode_machine::execution_state intcode_machine::run_native()
+{
+  intcode_native_state s{ program, input, *output_target, ip, relative_base };
+  const intcode_native_exit exit = native->run(s);
+  ip = s.ip;
+  relative_base = s.relative_base;
+  switch (exit)
+  {
+    case intcode_native_exit::halted: return execution_state::halted;
+    case intcode_native_exit::awaiting_input: return execution_state::awaiting_input;
+    case intcode_native_exit::awaiting_output: return execution_state::awaiting_output;
+    case intcode_native_exit::fallback:
+    default:
+    {
+      native = nullptr;
+      return execution_state::ready;
+    }
+  }
+}
+
+// Handlers are written once and expanded either as labels for computed goto,
+// or as cases of a switch for compilers without labels as values.
+// Loads the decoded instruction at ip, switching the current code page if needed.
+#define INTCODE_FETCH() \
+  do \
+  { \
+    offset = ip - code_base; \
+    if (code == nullptr || offset >= intcode_memory::page_size) \
+    { \
+      const uint64_t index = ip >> intcode_memory::page_bits; \
+      if (index >= directory_size || (code = directory[index].get()) == nullptr) goto slow_path; \
+      code_base = index << intcode_memory::page_bits; \
+      offset = ip - code_base; \
+    } \
+    if (offset + 3 >= intcode_memory::page_size) goto slow_path; \
+    instr = code->decoded[offset]; \
+  } while (0)
+
+#if INTCODE_THREADED_DISPATCH
+#define INTCODE_HANDLER(name) handle_##name
+#define INTCODE_NEXT() \
+  do \
+  { \
+    INTCODE_FETCH(); \
+    goto *handlers[(int)instr.op]; \
+  } while (0)
+#else
+#define INTCODE_HANDLER(name) case operation::name
+#define INTCODE_NEXT() goto dispatch
+#endif
+
+// Resolves operand 'arg' of 'instr' into the page and offset of the cell it refers to.
+// Leaves to the slow path on invalid argmode or unallocated pages, where single_step() handles it.
+#define INTCODE_ARG(arg, out_page, out_offset) \
+  do \
+  { \
+    const intcode_arg_mode mode = instr.modes[arg]; \
+    if (mode == arg_mode::immediate) \
+    { \
+      out_page = code; \
+      out_offset = offset + (arg) + 1; \
+    } \
+    else \
+    { \
+      uint64_t address = (uint64_t)code->cells[offset + (arg) + 1]; \
+      if (mode == arg_mode::relative) address += rb; \
+      else if (mode != arg_mode::position) goto slow_path; \
+      const uint64_t index = address >> intcode_memory::page_bits; \
+      if (index >= directory_size || (out_page = directory[index].get()) == nullptr) goto slow_path; \
+      out_offset = address & intcode_memory::page_mask; \
+    } \
+  } while (0)
+
+// Like INTCODE_ARG, for the operand an instruction writes to. Only exclusively owned pages
+// are written in place, shared and missing ones are copied/allocated by the slow path.
+#define INTCODE_DEST(arg, out_page, out_offset) \
+  do \
+  { \
+    const intcode_arg_mode mode = instr.modes[arg]; \
+    uint64_t address = ip + (arg) + 1; \
+    if (mode != arg_mode::immediate) \
+    { \
+      address = (uint64_t)code->cells[offset + (arg) + 1]; \
+      if (mode == arg_mode::relative) address += rb; \
+      else if (mode != arg_mode::position) goto slow_path; \
+    } \
+    const uint64_t index = address >> intcode_memory::page_bits; \
+    if (index >= directory_size || (out_page = writable[index]) == nullptr) goto slow_path; \
+    out_offset = address & intcode_memory::page_mask; \
+  } while (0)
+
+#define INTCODE_STORE(to_page, to_offset, value) \
+  do \
+  { \
+    (to_page)->cells[to_offset] = (value); \
+    (to_page)->decoded[to_offset].op = operation::undecoded; \
+  } while (0)
+
+intcode_machine::execution_state intcode_machine::run_fast()
 {
-  assert(arg >= 0);
-  int64_t pow = 100;
-  while (arg > 0)
+  using page = intcode_memory::page;
+
+  std::shared_ptr<page> const* directory = program.directory_data();
+  page* const* writable = program.writable_data();
+  uint64_t directory_size = program.directory_size();
+  uint64_t ip = this->ip;
+  int64_t rb = relative_base;
+  // Page holding the current instruction. Instructions near the end of a page
+  // (operands possibly on the next one) are left to the slow path.
+  page* code = nullptr;
+  uint64_t code_base = 0;
+  uint64_t offset = 0;
+  decoded_instruction instr;
+  page* pa;
+  page* pb;
+  page* pc;
+  uint64_t oa, ob, oc;
+
+#if INTCODE_THREADED_DISPATCH
+  static void* const handlers[(int)operation::count] = {
+    &&handle_undecoded,
+    &&handle_add,
+    &&handle_multiply,
+    &&handle_read_input,
+    &&handle_write_output,
+    &&handle_jump_if_true,
+    &&handle_jump_if_false,
+    &&handle_less_than,
+    &&handle_equals,
+    &&handle_change_relative_base,
+    &&handle_halt,
+    &&handle_invalid
+  };
+  INTCODE_NEXT();
+#else
+dispatch:
+  INTCODE_FETCH();
+  switch (instr.op)
+  {
+#endif
+
+  INTCODE_HANDLER(undecoded):
+  {
+    // Shared pages are fully decoded, so this page is ours to update.
+    code->decoded[offset] = decode_intcode_instruction(code->cells[offset]);
+    INTCODE_NEXT();
+  }
+  INTCODE_HANDLER(add):
+  {
+    INTCODE_ARG(0, pa, oa);
+    INTCODE_ARG(1, pb, ob);
+    INTCODE_DEST(2, pc, oc);
+    INTCODE_STORE(pc, oc, pa->cells[oa] + pb->cells[ob]);
+    ip += 4;
+    INTCODE_NEXT();
+  }
+  INTCODE_HANDLER(multiply):
+  {
+    INTCODE_ARG(0, pa, oa);
+    INTCODE_ARG(1, pb, ob);
+    INTCODE_DEST(2, pc, oc);
+    INTCODE_STORE(pc, oc, pa->cells[oa] * pb->cells[ob]);
+    ip += 4;
+    INTCODE_NEXT();
+  }
+  INTCODE_HANDLER(read_input):
+  {
+    int64_t value = 0;
+    if (input.empty())
+    {
+      this->ip = ip;
+      relative_base = rb;
+      return execution_state::awaiting_input;
+    }
+    INTCODE_DEST(0, pa, oa);
+    input.pop(value);
+    INTCODE_STORE(pa, oa, value);
+    ip += 2;
+    INTCODE_NEXT();
+  }
+  INTCODE_HANDLER(write_output):
+  {
+    INTCODE_ARG(0, pa, oa);
+    if (!output_target->push(pa->cells[oa]))
+    {
+      this->ip = ip;
+      relative_base = rb;
+      return execution_state::awaiting_output;
+    }
+    ip += 2;
+    INTCODE_NEXT();
+  }
+  INTCODE_HANDLER(jump_if_true):
+  {
+    INTCODE_ARG(0, pa, oa);
+    INTCODE_ARG(1, pb, ob);
+    ip = (pa->cells[oa] != 0) ? pb->cells[ob] : ip + 3;
+    INTCODE_NEXT();
+  }
+  INTCODE_HANDLER(jump_if_false):
+  {
+    INTCODE_ARG(0, pa, oa);
+    INTCODE_ARG(1, pb, ob);
+    ip = (pa->cells[oa] == 0) ? pb->cells[ob] : ip + 3;
+    INTCODE_NEXT();
+  }
+  INTCODE_HANDLER(less_than):
+  {
+    INTCODE_ARG(0, pa, oa);
+    INTCODE_ARG(1, pb, ob);
+    INTCODE_DEST(2, pc, oc);
+    INTCODE_STORE(pc, oc, pa->cells[oa] < pb->cells[ob] ? 1 : 0);
+    ip += 4;
+    INTCODE_NEXT();
+  }
+  INTCODE_HANDLER(equals):
+  {
+    INTCODE_ARG(0, pa, oa);
+    INTCODE_ARG(1, pb, ob);
+    INTCODE_DEST(2, pc, oc);
+    INTCODE_STORE(pc, oc, pa->cells[oa] == pb->cells[ob] ? 1 : 0);
+    ip += 4;
+    INTCODE_NEXT();
+  }
+  INTCODE_HANDLER(change_relative_base):
+  {
+    INTCODE_ARG(0, pa, oa);
+    rb += pa->cells[oa];
+    ip += 2;
+    INTCODE_NEXT();
+  }
+  INTCODE_HANDLER(halt):
+  {
+    this->ip = ip;
+    relative_base = rb;
+    return execution_state::halted;
+  }
+  INTCODE_HANDLER(invalid):
   {
-    pow *= 10;
-    arg--;
+    this->ip = ip;
+    relative_base = rb;
+    return execution_state::invalid_op;
   }
-  int64_t opmode_value = (opcode / pow) % 10;
-  switch (opmode_value)
+
+#if !INTCODE_THREADED_DISPATCH
+    default:
+    {
+      this->ip = ip;
+      relative_base = rb;
+      return execution_state::unknown_error;
+    }
+  }
+#endif
+
+slow_path:
+  // Rare cases (unallocated memory, bad argmodes, page boundaries) go through the reference implementation.
+  this->ip = ip;
+  relative_base = rb;
+  state = single_step();
+  if (state != execution_state::ready)
   {
-    case 0: return arg_mode::position;
-    case 1: return arg_mode::immediate;
-    case 2: return arg_mode::relative;
+    return state;
   }
-  return arg_mode::invalid;
+  directory = program.directory_data();
+  writable = program.writable_data();
+  directory_size = program.directory_size();
+  code = nullptr;
+  ip = this->ip;
+  rb = relative_base;
+  INTCODE_NEXT();
 }
 
-// Determine the position of the argument 'arg' based on current instruction.
+#undef INTCODE_FETCH
+#undef INTCODE_HANDLER
+#undef INTCODE_NEXT
+#undef INTCODE_ARG
+#undef INTCODE_DEST
+#undef INTCODE_STORE
+
+// Determine the position of the argument 'arg' of decoded instruction at ip.
 // If opmode of instruction is invalid, sets machine state to execution_state::error.
-uint64_t intcode_machine::arg_position(int64_t arg)
+uint64_t intcode_machine::arg_position(decoded_instruction const& instr, int64_t arg)
 {
-  int64_t opcode = program[ip];
-  arg_mode mode = get_argmode(opcode, arg);
   uint64_t pos = (uint64_t)-1;
-  switch (mode)
+  switch (instr.modes[arg])
   {
     case arg_mode::position:
     {
-      pos = program[ip + arg + 1];
+      pos = program.read(ip + arg + 1);
     }
     break;
     case arg_mode::immediate:
@@ -226,7 +706,7 @@ uint64_t intcode_machine::arg_position(int64_t arg)
     break;
     case arg_mode::relative:
     {
-      pos = program[ip + arg + 1] + relative_base;
+      pos = program.read(ip + arg + 1) + relative_base;
     }
     break;
     case arg_mode::invalid:
@@ -239,23 +719,48 @@ uint64_t intcode_machine::arg_position(int64_t arg)
   {
     state = execution_state::invalid_argmode;
   }
-  else if (pos + 1 > program.size())
-  {
-    program.resize(pos + 1, 0);
-  }
   return pos;
 }
 
+// One pass over the text after sizing the result from the comma count (both vectorized by the
+// compiler or the C library). Each cell is optional whitespace, an optional sign and decimal
+// digits, anything else up to the next comma is skipped. Empty cells read as 0.
 intcode_program read_intcode_program(const char * s)
 {
-  std::vector<int64_t> ret;
+  const char* const end = s + strlen(s);
+  intcode_program ret((size_t)std::count(s, end, ',') + 1);
+  int64_t* cell = ret.data();
   while (*s != '\0')
   {
-    int64_t v;
-    sscanf(s, "%lld", &v);
-    ret.push_back(v);
+    while (*s == ' ' || *s == '\n' || *s == '\r' || *s == '\t') s++;
+    const bool negative = *s == '-';
+    s += (negative || *s == '+') ? 1 : 0;
+    // Unsigned, so that the digits of INT64_MIN don't overflow.
+    uint64_t v = 0;
+    for (unsigned digit = (unsigned)(*s - '0'); digit < 10; digit = (unsigned)(*s - '0'))
+    {
+      v = v * 10 + digit;
+      s++;
+    }
+    *cell++ = (int64_t)(negative ? 0 - v : v);
     while (*s != ',' && *s != '\0') s++;
     if (*s == ',') s++;
   }
+  ret.resize(cell - ret.data());
   return ret;
 }
+
+intcode_program load_intcode_program(const char* s)
+{
+  return cached_parse("intcode", s, read_intcode_program,
+    [](parse_cache_writer& writer, intcode_program const& program)
+    {
+      writer.write_array(program.data(), program.size());
+    },
+    [](parse_cache_reader& reader)
+    {
+      size_t size = 0;
+      const int64_t* cells = reader.read_array<int64_t>(size);
+      return intcode_program(cells, cells + size);
+    });
+}
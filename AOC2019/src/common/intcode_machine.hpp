@@ -1,21 +1,30 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
-#include <queue>
 #include <utility>
 #include <vector>
 
-using intcode_program = std::vector<int64_t>;
+#include "common/intcode_jit.hpp"
+#include "common/intcode_memory.hpp"
+#include "common/intcode_native.hpp"
+#include "common/spsc_ring.hpp"
+
 intcode_program read_intcode_program(const char* s);
+// read_intcode_program() through the parse cache: repeated runs on the same input skip the parse.
+intcode_program load_intcode_program(const char* s);
 
 class intcode_machine
 {
 public:
   friend class intcode_machine_inspector;
+  friend class intcode_batch;
 
   enum class execution_state : int
   {
     ready = 0,
     awaiting_input = 1,
+    // Output is connected to another machine whose input is full.
+    awaiting_output = 2,
     halted = -1,
     instr_ptr_out_of_bounds = -2,
     invalid_op = -3,
@@ -28,27 +37,76 @@ public:
     return (int)state >= 0;
   }
 
+  using channel = spsc_ring<int64_t>;
+
   intcode_machine(intcode_program const& program);
-  intcode_machine(intcode_machine const& other) = default;
-  intcode_machine(intcode_machine&& other) = default;
-  intcode_machine& operator=(intcode_machine const& other) = default;
-  intcode_machine& operator=(intcode_machine&& other) = default;
+  // Copies are deep, use fork() for a copy-on-write one.
+  // Neither copies nor forks inherit a connection made with connect_output().
+  intcode_machine(intcode_machine const& other);
+  intcode_machine(intcode_machine&& other);
+  intcode_machine& operator=(intcode_machine const& other);
+  intcode_machine& operator=(intcode_machine&& other);
+
+  // Frozen machine state, see save().
+  class snapshot
+  {
+  public:
+    friend class intcode_machine;
+
+  private:
+    snapshot() = default;
+
+    intcode_memory program;
+    channel input;
+    channel output;
+    execution_state state = execution_state::ready;
+    uint64_t ip = 0;
+    int64_t relative_base = 0;
+    intcode_native_program const* native = nullptr;
+    std::shared_ptr<intcode_jit> jit;
+    uint32_t jit_invalidations = 0;
+    uint32_t jit_warmup = 0;
+  };
+
+  // Copy of the machine that shares memory pages with this one copy-on-write:
+  // creating it costs O(pages), and either machine later pays only for the pages it writes.
+  intcode_machine fork();
+
+  // Same sharing as fork(), for a state that is only restored and never run itself.
+  snapshot save();
+  // Puts the machine into the saved state. The snapshot can be restored any number of times.
+  void restore(snapshot const& s);
 
   void modify_program(uint64_t address, int64_t value);
-  void push_input(int64_t value);
+  // Inputs only fail to fit once connect_output() made the input ring fixed-size and it is full.
+  // Returns false if 'value' was dropped.
+  bool push_input(int64_t value);
+  // Returns how many of 'count' values were accepted, in order from the first.
+  size_t push_inputs(int64_t const* values, size_t count);
 
   // If pair.first == true, pair.second contains output value.
   // If pair.first == false, no output was produced.
   std::pair<bool, int64_t> pop_output();
+  // Moves up to 'max_count' outputs into 'values', returns how many were moved.
+  size_t drain_outputs(int64_t* values, size_t max_count);
+
+  // Sends outputs of this machine straight into the input of 'consumer'.
+  // The channel between them becomes a lock-free SPSC ring of at least 'capacity' values that
+  // no longer grows, so the two machines may run on different threads; this one stops with
+  // awaiting_output while the ring is full.
+  // push_input() on the consumer must then only be called from the producer's thread, and
+  // fails instead of growing the ring when it is full: check what it returns.
+  void connect_output(intcode_machine& consumer, size_t capacity);
 
   execution_state single_step();
 
-  // Runs single_step() until machine halts or asks for input when none is provided.
+  // Runs the machine until it halts or asks for input when none is provided.
+  // Executes exactly the same instructions as calling single_step() in a loop.
   execution_state run();
 
   bool has_output() const
   {
-    return output.size() > 0;
+    return !output.empty();
   }
 
   execution_state get_state() const
@@ -57,24 +115,43 @@ public:
   }
 
 private:
-  enum class arg_mode
-  {
-    position = 0,
-    immediate = 1,
-    relative = 2,
-    invalid = -1
-  };
-
-  static arg_mode get_argmode(int64_t opcode, int64_t arg);
-
-  uint64_t arg_position(int64_t arg);
-
-  intcode_program program;
-  std::queue<int64_t> input;
-  std::queue<int64_t> output;
+  explicit intcode_machine(intcode_memory&& memory);
+
+  using arg_mode = intcode_arg_mode;
+  using operation = intcode_operation;
+  using decoded_instruction = intcode_instruction;
+
+  // Same semantics as repeated single_step(), but keeps registers in locals and
+  // only leaves the loop when the machine stops or touches unallocated memory.
+  execution_state run_fast();
+  // Runs the translated program until it stops or falls back to the interpreter.
+  execution_state run_native();
+  // Runs compiled code, stepping the interpreter over whatever it leaves, until the machine
+  // stops or the program rewrote its code too often.
+  execution_state run_jit();
+
+  // Writes a cell on behalf of the program, dropping compiled code that covers it.
+  void write_memory(uint64_t address, int64_t value);
+
+  uint64_t arg_position(decoded_instruction const& instr, int64_t arg);
+
+  intcode_memory program;
+  channel input;
+  channel output;
+  // Where outputs go: 'output' unless connected to another machine.
+  channel* output_target = &output;
   execution_state state = execution_state::ready;
   uint64_t ip = 0;
   int64_t relative_base = 0;
+  // Ahead-of-time translation of the program, if one was linked in (see intcode_translator.hpp).
+  // Dropped for good once translated code is modified from outside or the native code falls back.
+  intcode_native_program const* native = nullptr;
+  // Just-in-time compiled code (see intcode_jit.hpp), created on first run() when enabled.
+  // Shared copy-on-write with forks and snapshots, dropped whenever the program writes into it.
+  std::shared_ptr<intcode_jit> jit;
+  uint32_t jit_invalidations = 0;
+  // Instructions interpreted before the cache was first created.
+  uint32_t jit_warmup = 0;
 };
 
 class intcode_machine_inspector
@@ -84,7 +161,7 @@ public:
   {
   };
 
-  intcode_program const& program() const
+  intcode_memory const& program() const
   {
     return machine.program;
   }
@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <cassert>
+
+#include "common/intcode_memory.hpp"
+
+constexpr uint64_t intcode_memory::page_bits;
+constexpr uint64_t intcode_memory::page_size;
+constexpr uint64_t intcode_memory::page_mask;
+constexpr uint64_t intcode_memory::directory_limit;
+
+intcode_memory::intcode_memory(intcode_program const& image)
+{
+  for (uint64_t first = 0; first < image.size(); first += page_size)
+  {
+    page* p = make_writable(first >> page_bits);
+    const uint64_t count = std::min<uint64_t>(page_size, image.size() - first);
+    std::copy(image.begin() + first, image.begin() + first + count, p->cells);
+  }
+}
+
+intcode_memory::intcode_memory(intcode_memory const& other)
+{
+  *this = other;
+}
+
+// Deep copy, the result owns all of its pages.
+intcode_memory& intcode_memory::operator=(intcode_memory const& other)
+{
+  if (this == &other)
+  {
+    return *this;
+  }
+  directory.clear();
+  writable.clear();
+  directory.resize(other.directory.size());
+  writable.resize(other.directory.size());
+  readable.assign(other.directory.size(), nullptr);
+  for (uint64_t i = 0; i < other.directory.size(); i++)
+  {
+    if (other.directory[i])
+    {
+      directory[i] = std::make_shared<page>(*other.directory[i]);
+      writable[i] = directory[i].get();
+      readable[i] = directory[i].get();
+    }
+  }
+  far_pages.clear();
+  for (auto const& p : other.far_pages)
+  {
+    far_pages.emplace(p.first, std::make_shared<page>(*p.second));
+  }
+  extent = other.extent;
+  return *this;
+}
+
+intcode_memory intcode_memory::share()
+{
+  for (uint64_t i = 0; i < writable.size(); i++)
+  {
+    if (writable[i])
+    {
+      decode_all(*writable[i]);
+      writable[i] = nullptr;
+    }
+  }
+  for (auto& p : far_pages)
+  {
+    if (p.second.use_count() == 1)
+    {
+      decode_all(*p.second);
+    }
+  }
+  return share_unowned();
+}
+
+intcode_memory intcode_memory::share_unowned() const
+{
+  assert(std::all_of(writable.begin(), writable.end(), [](page* p) { return p == nullptr; }));
+  intcode_memory ret;
+  ret.directory = directory;
+  ret.readable = readable;
+  ret.writable.resize(directory.size(), nullptr);
+  ret.far_pages = far_pages;
+  ret.extent = extent;
+  return ret;
+}
+
+intcode_instruction const& intcode_memory::instruction_at(uint64_t address)
+{
+  static const intcode_instruction zero_cell = decode_intcode_instruction(0);
+  page const* p = find_page(address);
+  if (p == nullptr)
+  {
+    return zero_cell;
+  }
+  intcode_instruction const& instr = p->decoded[address & page_mask];
+  if (instr.op != intcode_operation::undecoded)
+  {
+    return instr;
+  }
+  // Undecoded entries only exist in exclusively owned pages.
+  page* owned = page_for_write(address);
+  owned->decoded[address & page_mask] = decode_intcode_instruction(owned->cells[address & page_mask]);
+  return owned->decoded[address & page_mask];
+}
+
+uint64_t intcode_memory::num_pages() const
+{
+  uint64_t ret = far_pages.size();
+  for (auto const& p : directory)
+  {
+    ret += p ? 1 : 0;
+  }
+  return ret;
+}
+
+intcode_memory::page const* intcode_memory::find_far_page(uint64_t index) const
+{
+  auto it = far_pages.find(index);
+  return it != far_pages.end() ? it->second.get() : nullptr;
+}
+
+intcode_memory::page* intcode_memory::make_writable(uint64_t index)
+{
+  std::shared_ptr<page>* slot = nullptr;
+  if (index < directory_limit)
+  {
+    if (index >= directory.size())
+    {
+      directory.resize(index + 1);
+      writable.resize(index + 1, nullptr);
+      readable.resize(index + 1, nullptr);
+    }
+    slot = &directory[index];
+  }
+  else
+  {
+    slot = &far_pages[index];
+  }
+
+  if (*slot == nullptr)
+  {
+    *slot = std::make_shared<page>();
+    extent = std::max(extent, (index + 1) << page_bits);
+  }
+  else if (slot->use_count() > 1)
+  {
+    *slot = std::make_shared<page>(**slot);
+  }
+
+  if (index < directory_limit)
+  {
+    writable[index] = slot->get();
+    readable[index] = slot->get();
+  }
+  return slot->get();
+}
+
+void intcode_memory::decode_all(page& p)
+{
+  for (uint64_t i = 0; i < page_size; i++)
+  {
+    if (p.decoded[i].op == intcode_operation::undecoded)
+    {
+      p.decoded[i] = decode_intcode_instruction(p.cells[i]);
+    }
+  }
+}
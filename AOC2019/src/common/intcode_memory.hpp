@@ -0,0 +1,139 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "common/intcode_instruction.hpp"
+
+using intcode_program = std::vector<int64_t>;
+
+// Intcode address space split into fixed-size pages.
+// Pages are allocated on first write, reads of untouched addresses return 0.
+// Low pages (the program image and whatever is close to it) are found through a flat directory,
+// far addresses go through a hash map, so memory use follows the pages actually touched.
+//
+// Pages can be shared between memories (see share()) and are copied on the first write
+// through a memory that doesn't own them exclusively.
+// Shared pages are always fully decoded, so only exclusively owned pages ever get
+// their decoded entries filled in.
+class intcode_memory
+{
+public:
+  static constexpr uint64_t page_bits = 9;
+  static constexpr uint64_t page_size = (uint64_t)1 << page_bits;
+  static constexpr uint64_t page_mask = page_size - 1;
+  // Pages with index below this limit live in the directory (16M cells).
+  static constexpr uint64_t directory_limit = (uint64_t)1 << 15;
+
+  struct page
+  {
+    int64_t cells[page_size];
+    // Decoded form of each cell, reset on every write to the cell.
+    intcode_instruction decoded[page_size];
+  };
+
+  intcode_memory() = default;
+  explicit intcode_memory(intcode_program const& image);
+  intcode_memory(intcode_memory const& other);
+  intcode_memory(intcode_memory&& other) = default;
+  intcode_memory& operator=(intcode_memory const& other);
+  intcode_memory& operator=(intcode_memory&& other) = default;
+
+  // Copy that shares every page with this memory. Costs one pointer per page;
+  // afterwards each side copies a page on its first write to it.
+  intcode_memory share();
+
+  // Like share(), for memories that don't own any page exclusively (ones created by share()
+  // and never written to), where sharing doesn't need to modify the source.
+  intcode_memory share_unowned() const;
+
+  // One past the end of the highest allocated page. Every address below it can be read,
+  // the ones in pages that were never written read as 0.
+  uint64_t size() const
+  {
+    return extent;
+  }
+
+  int64_t operator[](uint64_t address) const
+  {
+    return read(address);
+  }
+
+  int64_t read(uint64_t address) const
+  {
+    page const* p = find_page(address);
+    return p ? p->cells[address & page_mask] : 0;
+  }
+
+  void write(uint64_t address, int64_t value)
+  {
+    page* p = page_for_write(address);
+    p->cells[address & page_mask] = value;
+    p->decoded[address & page_mask].op = intcode_operation::undecoded;
+  }
+
+  // Decoded form of the cell at 'address', decoded on first use.
+  intcode_instruction const& instruction_at(uint64_t address);
+
+  // Page holding 'address', or nullptr if nothing was written there yet. Read only.
+  page const* find_page(uint64_t address) const
+  {
+    const uint64_t index = address >> page_bits;
+    if (index < directory.size())
+    {
+      return directory[index].get();
+    }
+    return index < directory_limit ? nullptr : find_far_page(index);
+  }
+
+  // Exclusively owned page holding 'address', allocated or unshared if needed.
+  page* page_for_write(uint64_t address)
+  {
+    const uint64_t index = address >> page_bits;
+    if (index < writable.size() && writable[index])
+    {
+      return writable[index];
+    }
+    return make_writable(index);
+  }
+
+  // Flat directories for callers that cache page lookups (run loops).
+  // All have directory_size() entries; writable entries are null for pages that
+  // are missing or shared, which have to go through page_for_write().
+  std::shared_ptr<page> const* directory_data() const
+  {
+    return directory.data();
+  }
+
+  // Same pages as directory_data(), as plain pointers for generated code.
+  page const* const* readable_data() const
+  {
+    return readable.data();
+  }
+
+  page* const* writable_data() const
+  {
+    return writable.data();
+  }
+
+  uint64_t directory_size() const
+  {
+    return directory.size();
+  }
+
+  uint64_t num_pages() const;
+
+private:
+  page const* find_far_page(uint64_t index) const;
+  page* make_writable(uint64_t index);
+  static void decode_all(page& p);
+
+  std::vector<std::shared_ptr<page>> directory;
+  // directory[i].get()
+  std::vector<page const*> readable;
+  // Pages of 'directory' this memory owns exclusively.
+  std::vector<page*> writable;
+  std::unordered_map<uint64_t, std::shared_ptr<page>> far_pages;
+  uint64_t extent = 0;
+};
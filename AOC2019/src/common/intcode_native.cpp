@@ -0,0 +1,31 @@
+#include <algorithm>
+#include <vector>
+
+#include "common/intcode_native.hpp"
+
+namespace
+{
+  // Function-local so that registrars in other translation units can use it during static initialization.
+  std::vector<intcode_native_program const*>& native_programs()
+  {
+    static std::vector<intcode_native_program const*> programs;
+    return programs;
+  }
+}
+
+intcode_native_program const* find_intcode_native_program(intcode_program const& image)
+{
+  for (intcode_native_program const* p : native_programs())
+  {
+    if (p->size == image.size() && std::equal(image.begin(), image.end(), p->image))
+    {
+      return p;
+    }
+  }
+  return nullptr;
+}
+
+intcode_native_registrar::intcode_native_registrar(intcode_native_program const& program)
+{
+  native_programs().push_back(&program);
+}
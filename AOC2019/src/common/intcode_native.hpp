@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "common/intcode_memory.hpp"
+#include "common/spsc_ring.hpp"
+
+// Interface between intcode_machine and programs compiled to C++ by translate_intcode_program().
+// A translated program registers itself by its image. Machines created from the same image
+// run the native code instead of the interpreter.
+
+// Registers of the machine, updated by the native code when it returns.
+struct intcode_native_state
+{
+  intcode_memory& memory;
+  spsc_ring<int64_t>& input;
+  spsc_ring<int64_t>& output;
+  uint64_t ip;
+  int64_t relative_base;
+};
+
+enum class intcode_native_exit
+{
+  halted,
+  awaiting_input,
+  awaiting_output,
+  // The program jumped to an address the translator didn't see as code, or wrote into its
+  // translated code. The interpreter continues from 'ip' and the native code isn't used again,
+  // as the interpreter might change translated code without anyone noticing.
+  fallback
+};
+
+using intcode_native_function = intcode_native_exit (*)(intcode_native_state& state);
+
+struct intcode_native_program
+{
+  int64_t const* image;
+  // Per cell of the image: part of a translated instruction, so writing it invalidates the translation.
+  uint8_t const* translated;
+  size_t size;
+  intcode_native_function run;
+
+  bool is_translated(uint64_t address) const
+  {
+    return address < size && translated[address] != 0;
+  }
+};
+
+// Translated program for 'image', or nullptr if there is none.
+intcode_native_program const* find_intcode_native_program(intcode_program const& image);
+
+// Used by generated code to register itself during static initialization.
+class intcode_native_registrar
+{
+public:
+  explicit intcode_native_registrar(intcode_native_program const& program);
+};
+
+// Exits native code with the registers synced back to 'state'. Used by generated code.
+#define INTCODE_NATIVE_EXIT(at, reason) \
+  do \
+  { \
+    s.ip = (uint64_t)(at); \
+    s.relative_base = rb; \
+    return intcode_native_exit::reason; \
+  } while (0)
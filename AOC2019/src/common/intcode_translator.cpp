@@ -0,0 +1,371 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/intcode_instruction.hpp"
+#include "common/intcode_translator.hpp"
+
+namespace
+{
+  using arg_mode = intcode_arg_mode;
+  using operation = intcode_operation;
+
+  bool is_valid(intcode_instruction const& instr)
+  {
+    if (instr.op == operation::invalid)
+    {
+      return false;
+    }
+    for (int i = 0; i < instr.num_args; i++)
+    {
+      if (instr.modes[i] == arg_mode::invalid)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::string literal(int64_t value)
+  {
+    char buf[32];
+    if (value == INT64_MIN)
+    {
+      return "(-9223372036854775807LL - 1)";
+    }
+    sprintf(buf, "%lldLL", value);
+    return buf;
+  }
+
+  class translator
+  {
+  public:
+    translator(intcode_program const& program, FILE* out)
+      : program(program)
+      , out(out)
+      , is_instruction(program.size(), 0)
+      , is_code(program.size(), 0)
+    {
+    }
+
+    void translate()
+    {
+      trace(0, false);
+      find_return_addresses();
+      emit();
+    }
+
+  private:
+    uint64_t size() const
+    {
+      return program.size();
+    }
+
+    intcode_instruction instruction_at(uint64_t address) const
+    {
+      return decode_intcode_instruction(program[address]);
+    }
+
+    // Marks instructions reachable from 'entry' through fall-through and constant jumps.
+    // With 'strict', marks nothing and returns false if an invalid instruction is reachable:
+    // the entry is likely data that only looks like a code address.
+    bool trace(uint64_t entry, bool strict)
+    {
+      std::vector<uint64_t> pending{ entry };
+      std::vector<uint64_t> found;
+      std::vector<uint8_t> visited(size(), 0);
+      while (!pending.empty())
+      {
+        const uint64_t address = pending.back();
+        pending.pop_back();
+        if (address >= size() || is_instruction[address] || visited[address])
+        {
+          continue;
+        }
+        visited[address] = 1;
+
+        const intcode_instruction instr = instruction_at(address);
+        if (!is_valid(instr) || address + instr.num_args >= size())
+        {
+          // Left to the interpreter, which reports the error.
+          if (strict)
+          {
+            return false;
+          }
+          continue;
+        }
+        found.push_back(address);
+
+        const uint64_t next = address + 1 + instr.num_args;
+        switch (instr.op)
+        {
+          case operation::halt:
+            break;
+          case operation::jump_if_true:
+          case operation::jump_if_false:
+            pending.push_back(next);
+            if (instr.modes[1] == arg_mode::immediate)
+            {
+              pending.push_back((uint64_t)program[address + 2]);
+            }
+            break;
+          default:
+            pending.push_back(next);
+            break;
+        }
+      }
+
+      for (uint64_t address : found)
+      {
+        is_instruction[address] = 1;
+        for (uint64_t i = 0; i <= instruction_at(address).num_args; i++)
+        {
+          is_code[address + i] = 1;
+        }
+      }
+      return true;
+    }
+
+    // Code reached only through computed jumps, typically returns from subroutines.
+    // Return addresses are pushed as an immediate value added to immediate 0.
+    void find_return_addresses()
+    {
+      bool found_new = true;
+      while (found_new)
+      {
+        found_new = false;
+        for (uint64_t address = 0; address < size(); address++)
+        {
+          if (!is_instruction[address])
+          {
+            continue;
+          }
+          const intcode_instruction instr = instruction_at(address);
+          if (instr.op != operation::add || instr.modes[0] != arg_mode::immediate || instr.modes[1] != arg_mode::immediate)
+          {
+            continue;
+          }
+          const int64_t a = program[address + 1];
+          const int64_t b = program[address + 2];
+          const int64_t value = a == 0 ? b : (b == 0 ? a : -1);
+          if (value >= 0 && (uint64_t)value < size() && !is_instruction[value] && trace(value, true))
+          {
+            found_new = true;
+          }
+        }
+      }
+    }
+
+    // Expression reading operand 'arg' of the instruction at 'address'.
+    // Translated code cells are constant, so immediate operands become literals.
+    std::string read(uint64_t address, int arg) const
+    {
+      const int64_t cell = program[address + 1 + arg];
+      char buf[64];
+      switch (instruction_at(address).modes[arg])
+      {
+        case arg_mode::immediate:
+          return literal(cell);
+        case arg_mode::position:
+          sprintf(buf, "m.read(%lluULL)", (uint64_t)cell);
+          return buf;
+        case arg_mode::relative:
+        default:
+          return "m.read((uint64_t)(rb + " + literal(cell) + "))";
+      }
+    }
+
+    // Writes 'v' to operand 'arg', leaving native code if that changes translated code.
+    void emit_store(uint64_t address, int arg)
+    {
+      const uint64_t next = address + 2 + arg;
+      const uint64_t operand = address + 1 + arg;
+      const int64_t cell = program[operand];
+      switch (instruction_at(address).modes[arg])
+      {
+        case arg_mode::immediate:
+          fprintf(out, "    m.write(%lluULL, v);\n", operand);
+          fprintf(out, "    INTCODE_NATIVE_EXIT(%lluULL, fallback);\n", next);
+          break;
+        case arg_mode::position:
+          fprintf(out, "    m.write(%lluULL, v);\n", (uint64_t)cell);
+          if ((uint64_t)cell < size() && is_code[cell])
+          {
+            fprintf(out, "    INTCODE_NATIVE_EXIT(%lluULL, fallback);\n", next);
+          }
+          break;
+        case arg_mode::relative:
+        default:
+          fprintf(out, "    const uint64_t w = (uint64_t)(rb + %s);\n", literal(cell).c_str());
+          fprintf(out, "    m.write(w, v);\n");
+          fprintf(out, "    if (w < %lluULL && translated[w]) INTCODE_NATIVE_EXIT(%lluULL, fallback);\n", size(), next);
+          break;
+      }
+    }
+
+    void emit_goto(uint64_t target)
+    {
+      if (target < size() && is_instruction[target])
+      {
+        fprintf(out, "goto i%llu;", target);
+      }
+      else
+      {
+        fprintf(out, "INTCODE_NATIVE_EXIT(%lluULL, fallback);", target);
+      }
+    }
+
+    void emit_jump(uint64_t address, bool if_true)
+    {
+      const intcode_instruction instr = instruction_at(address);
+      fprintf(out, "    if (%s %s 0) ", read(address, 0).c_str(), if_true ? "!=" : "==");
+      if (instr.modes[1] == arg_mode::immediate)
+      {
+        emit_goto((uint64_t)program[address + 2]);
+        fprintf(out, "\n");
+      }
+      else
+      {
+        fprintf(out, "{ ip = (uint64_t)%s; goto dispatch; }\n", read(address, 1).c_str());
+      }
+    }
+
+    void emit_instruction(uint64_t address)
+    {
+      const intcode_instruction instr = instruction_at(address);
+      fprintf(out, "  i%llu: //", address);
+      for (int i = 0; i <= instr.num_args; i++)
+      {
+        fprintf(out, " %lld", program[address + i]);
+      }
+      fprintf(out, "\n  {\n");
+      switch (instr.op)
+      {
+        case operation::add:
+          fprintf(out, "    const int64_t v = %s + %s;\n", read(address, 0).c_str(), read(address, 1).c_str());
+          emit_store(address, 2);
+          break;
+        case operation::multiply:
+          fprintf(out, "    const int64_t v = %s * %s;\n", read(address, 0).c_str(), read(address, 1).c_str());
+          emit_store(address, 2);
+          break;
+        case operation::read_input:
+          fprintf(out, "    if (s.input.empty()) INTCODE_NATIVE_EXIT(%lluULL, awaiting_input);\n", address);
+          fprintf(out, "    int64_t v = 0;\n");
+          fprintf(out, "    s.input.pop(v);\n");
+          emit_store(address, 0);
+          break;
+        case operation::write_output:
+          fprintf(out, "    if (!s.output.push(%s)) INTCODE_NATIVE_EXIT(%lluULL, awaiting_output);\n", read(address, 0).c_str(), address);
+          break;
+        case operation::jump_if_true:
+          emit_jump(address, true);
+          break;
+        case operation::jump_if_false:
+          emit_jump(address, false);
+          break;
+        case operation::less_than:
+          fprintf(out, "    const int64_t v = %s < %s ? 1 : 0;\n", read(address, 0).c_str(), read(address, 1).c_str());
+          emit_store(address, 2);
+          break;
+        case operation::equals:
+          fprintf(out, "    const int64_t v = %s == %s ? 1 : 0;\n", read(address, 0).c_str(), read(address, 1).c_str());
+          emit_store(address, 2);
+          break;
+        case operation::change_relative_base:
+          fprintf(out, "    rb += %s;\n", read(address, 0).c_str());
+          break;
+        case operation::halt:
+        default:
+          fprintf(out, "    INTCODE_NATIVE_EXIT(%lluULL, halted);\n", address);
+          break;
+      }
+      fprintf(out, "  }\n");
+
+      // Fall through to the next instruction, unless it's also the next one emitted.
+      const uint64_t next = address + 1 + instr.num_args;
+      if (instr.op != operation::halt && (next >= size() || !is_instruction[next] || next_instruction(address) != next))
+      {
+        fprintf(out, "  ");
+        emit_goto(next);
+        fprintf(out, "\n");
+      }
+    }
+
+    uint64_t next_instruction(uint64_t address) const
+    {
+      address++;
+      while (address < size() && !is_instruction[address])
+      {
+        address++;
+      }
+      return address;
+    }
+
+    void emit_array(const char* declaration, bool code_map)
+    {
+      fprintf(out, "%s[%llu] = {", declaration, size() > 0 ? size() : 1);
+      for (uint64_t i = 0; i < size(); i++)
+      {
+        fprintf(out, "%s", i % 16 == 0 ? "\n  " : " ");
+        if (code_map)
+        {
+          fprintf(out, "%d,", (int)is_code[i]);
+        }
+        else
+        {
+          fprintf(out, "%s,", literal(program[i]).c_str());
+        }
+      }
+      fprintf(out, "\n};\n");
+    }
+
+    void emit()
+    {
+      fprintf(out, "// Generated by translate_intcode_program() from a %llu-cell Intcode program, do not edit.\n", size());
+      fprintf(out, "#include \"common/intcode_native.hpp\"\n\n");
+      fprintf(out, "namespace\n{\n");
+      emit_array("const int64_t image", false);
+      fprintf(out, "\n// Cells of translated instructions, writing to them leaves native code.\n");
+      emit_array("const uint8_t translated", true);
+
+      fprintf(out, "\nintcode_native_exit run(intcode_native_state& s)\n{\n");
+      fprintf(out, "  intcode_memory& m = s.memory;\n");
+      fprintf(out, "  uint64_t ip = s.ip;\n");
+      fprintf(out, "  int64_t rb = s.relative_base;\n\n");
+      fprintf(out, "dispatch:\n");
+      fprintf(out, "  switch (ip)\n  {\n");
+      for (uint64_t address = 0; address < size(); address++)
+      {
+        if (is_instruction[address])
+        {
+          fprintf(out, "    case %llu: goto i%llu;\n", address, address);
+        }
+      }
+      fprintf(out, "    default: INTCODE_NATIVE_EXIT(ip, fallback);\n");
+      fprintf(out, "  }\n\n");
+      for (uint64_t address = 0; address < size(); address++)
+      {
+        if (is_instruction[address])
+        {
+          emit_instruction(address);
+        }
+      }
+      fprintf(out, "}\n\n");
+      fprintf(out, "const intcode_native_program program = { image, translated, %llu, &run };\n", size());
+      fprintf(out, "const intcode_native_registrar registrar(program);\n");
+      fprintf(out, "}\n");
+    }
+
+    intcode_program const& program;
+    FILE* out;
+    std::vector<uint8_t> is_instruction;
+    // Cells of translated instructions (opcodes and operands).
+    std::vector<uint8_t> is_code;
+  };
+}
+
+void translate_intcode_program(intcode_program const& program, FILE* out)
+{
+  translator(program, out).translate();
+}
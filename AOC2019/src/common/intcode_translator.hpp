@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdio>
+
+#include "common/intcode_memory.hpp"
+
+// Writes a C++ translation unit that implements 'program' natively and registers it
+// for intcode_machine (see intcode_native.hpp).
+//
+// Instructions reachable from address 0, and from return addresses the program pushes
+// (immediate values moved into memory that point at valid code), become labeled blocks
+// of straight-line code with constant operands. Jumps with constant targets are gotos,
+// computed ones go through a switch over the known instruction addresses.
+// The interpreter takes over on jumps to unknown addresses and on writes into translated code.
+void translate_intcode_program(intcode_program const& program, FILE* out);
@@ -0,0 +1,235 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// Ring buffer with a single producer and a single consumer.
+// Indices grow monotonically and are masked into a power-of-two buffer, producer and consumer
+// each write only their own index, so with growth disabled the ring is a lock-free channel
+// between two threads.
+// While growable (both ends used from the same thread), push() reallocates instead of failing.
+template <class T>
+class spsc_ring
+{
+public:
+  explicit spsc_ring(size_t capacity = 16)
+  {
+    size_t c = 1;
+    while (c < capacity)
+    {
+      c *= 2;
+    }
+    buffer.reset(new T[c]);
+    mask = c - 1;
+  }
+
+  // Copies take the current contents and start out growable.
+  // Neither side may be in use by another thread.
+  spsc_ring(spsc_ring const& other) : spsc_ring(other.size())
+  {
+    copy_from(other);
+  }
+
+  // Moves leave 'other' empty. Neither side may be in use by another thread.
+  spsc_ring(spsc_ring&& other) : spsc_ring()
+  {
+    swap(other);
+  }
+
+  spsc_ring& operator=(spsc_ring&& other)
+  {
+    if (this != &other)
+    {
+      spsc_ring tmp;
+      tmp.swap(other);
+      swap(tmp);
+    }
+    return *this;
+  }
+
+  spsc_ring& operator=(spsc_ring const& other)
+  {
+    if (this != &other)
+    {
+      head.store(0, std::memory_order_relaxed);
+      tail.store(0, std::memory_order_relaxed);
+      copy_from(other);
+    }
+    return *this;
+  }
+
+  size_t capacity() const
+  {
+    return mask + 1;
+  }
+
+  size_t size() const
+  {
+    return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+  }
+
+  bool empty() const
+  {
+    return size() == 0;
+  }
+
+  bool is_growable() const
+  {
+    return growable;
+  }
+
+  // Makes room for at least 'new_capacity' values. Neither end may be in use by another thread.
+  void reserve(size_t new_capacity)
+  {
+    size_t c = capacity();
+    while (c < new_capacity)
+    {
+      c *= 2;
+    }
+    if (c != capacity())
+    {
+      grow(c);
+    }
+  }
+
+  // Disable before handing one end to another thread.
+  void set_growable(bool value)
+  {
+    growable = value;
+  }
+
+  // Producer side. Whether push() would succeed.
+  bool can_push() const
+  {
+    return growable || tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire) <= mask;
+  }
+
+  // Producer side. Fails only if the ring is full and can't grow.
+  bool push(T const& value)
+  {
+    const size_t t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) > mask)
+    {
+      if (!growable)
+      {
+        return false;
+      }
+      grow(capacity() * 2);
+    }
+    buffer[t & mask] = value;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Producer side. Returns how many of 'count' values were pushed.
+  size_t push_bulk(T const* values, size_t count)
+  {
+    const size_t t = tail.load(std::memory_order_relaxed);
+    size_t free_space = capacity() - (t - head.load(std::memory_order_acquire));
+    if (free_space < count && growable)
+    {
+      size_t c = capacity();
+      while (c - (t - head.load(std::memory_order_relaxed)) < count)
+      {
+        c *= 2;
+      }
+      grow(c);
+      free_space = capacity() - (t - head.load(std::memory_order_relaxed));
+    }
+    const size_t n = std::min(count, free_space);
+    for (size_t i = 0; i < n; i++)
+    {
+      buffer[(t + i) & mask] = values[i];
+    }
+    tail.store(t + n, std::memory_order_release);
+    return n;
+  }
+
+  // Consumer side.
+  bool pop(T& value)
+  {
+    const size_t h = head.load(std::memory_order_relaxed);
+    if (tail.load(std::memory_order_acquire) == h)
+    {
+      return false;
+    }
+    value = buffer[h & mask];
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Returns how many values were written to 'values'.
+  size_t pop_bulk(T* values, size_t max_count)
+  {
+    const size_t h = head.load(std::memory_order_relaxed);
+    const size_t n = std::min(max_count, tail.load(std::memory_order_acquire) - h);
+    for (size_t i = 0; i < n; i++)
+    {
+      values[i] = buffer[(h + i) & mask];
+    }
+    head.store(h + n, std::memory_order_release);
+    return n;
+  }
+
+  // Consumer side. Oldest value, the ring must not be empty.
+  T const& front() const
+  {
+    return buffer[head.load(std::memory_order_relaxed) & mask];
+  }
+
+private:
+  // Only called by the producer of a growable ring or by reserve(), so the consumer can't be
+  // reading concurrently.
+  void grow(size_t new_capacity)
+  {
+    const size_t h = head.load(std::memory_order_relaxed);
+    const size_t t = tail.load(std::memory_order_relaxed);
+    std::unique_ptr<T[]> new_buffer(new T[new_capacity]);
+    for (size_t i = h; i != t; i++)
+    {
+      new_buffer[i & (new_capacity - 1)] = buffer[i & mask];
+    }
+    buffer = std::move(new_buffer);
+    mask = new_capacity - 1;
+  }
+
+  void swap(spsc_ring& other)
+  {
+    std::swap(buffer, other.buffer);
+    std::swap(mask, other.mask);
+    std::swap(growable, other.growable);
+    const size_t h = head.load(std::memory_order_relaxed);
+    const size_t t = tail.load(std::memory_order_relaxed);
+    head.store(other.head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    tail.store(other.tail.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    other.head.store(h, std::memory_order_relaxed);
+    other.tail.store(t, std::memory_order_relaxed);
+  }
+
+  void copy_from(spsc_ring const& other)
+  {
+    const size_t h = other.head.load(std::memory_order_acquire);
+    const size_t t = other.tail.load(std::memory_order_acquire);
+    if (t - h > capacity())
+    {
+      buffer.reset(new T[other.capacity()]);
+      mask = other.capacity() - 1;
+    }
+    for (size_t i = h; i != t; i++)
+    {
+      buffer[(i - h) & mask] = other.buffer[i & other.mask];
+    }
+    tail.store(t - h, std::memory_order_release);
+  }
+
+  std::unique_ptr<T[]> buffer;
+  size_t mask = 0;
+  bool growable = true;
+  // Consumer and producer indices kept apart so they don't share a cache line.
+  // Padded rather than aligned: machines holding rings are placement-new'ed into plain char buffers.
+  std::atomic<size_t> head{ 0 };
+  char padding[64 - sizeof(std::atomic<size_t>)];
+  std::atomic<size_t> tail{ 0 };
+};
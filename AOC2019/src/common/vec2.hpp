@@ -1,6 +1,8 @@
 #pragma once
 #include <cstdint>
 
+#include "common/hash.hpp"
+
 struct vec2
 {
   vec2() : x{0}, y{0} {}
@@ -60,6 +62,6 @@ struct vec2_hasher
 {
   inline uint64_t operator()(vec2 v) const
   {
-    return v.x + v.y;
+    return hash_mix(hash_pack(v.x, v.y));
   }
 };
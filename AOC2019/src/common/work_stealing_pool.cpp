@@ -0,0 +1,124 @@
+#include "common/work_stealing_pool.hpp"
+
+namespace
+{
+  // Worker the current thread belongs to, so submit() from a task can use the local deque.
+  thread_local work_stealing_pool const* current_pool = nullptr;
+  thread_local size_t current_index = 0;
+}
+
+work_stealing_pool::work_stealing_pool(size_t num_threads)
+{
+  if (num_threads == 0)
+  {
+    num_threads = std::thread::hardware_concurrency();
+  }
+  if (num_threads == 0)
+  {
+    num_threads = 1;
+  }
+  for (size_t i = 0; i < num_threads; i++)
+  {
+    queues.push_back(std::unique_ptr<worker_queue>(new worker_queue()));
+  }
+  for (size_t i = 0; i < num_threads; i++)
+  {
+    threads.emplace_back([this, i]() { worker_loop(i); });
+  }
+}
+
+work_stealing_pool::~work_stealing_pool()
+{
+  wait();
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  work_available.notify_all();
+  for (std::thread& thread : threads)
+  {
+    thread.join();
+  }
+}
+
+void work_stealing_pool::submit(std::function<void()> task)
+{
+  const size_t index = current_pool == this ? current_index : next_queue.fetch_add(1) % queues.size();
+  {
+    // Counted before the push, so a worker that takes the task never sees the counters go below zero.
+    std::lock_guard<std::mutex> lock(mutex);
+    num_pending++;
+    num_queued++;
+  }
+  {
+    std::lock_guard<std::mutex> lock(queues[index]->mutex);
+    queues[index]->tasks.push_back(std::move(task));
+  }
+  work_available.notify_one();
+}
+
+void work_stealing_pool::wait()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  all_done.wait(lock, [this]() { return num_pending == 0; });
+}
+
+void work_stealing_pool::worker_loop(size_t index)
+{
+  current_pool = this;
+  current_index = index;
+  for (;;)
+  {
+    std::function<void()> task;
+    if (pop_local(index, task) || steal(index, task))
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        num_queued--;
+      }
+      task();
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--num_pending == 0)
+      {
+        all_done.notify_all();
+      }
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    work_available.wait(lock, [this]() { return stopping || num_queued > 0; });
+    if (stopping && num_queued == 0)
+    {
+      return;
+    }
+  }
+}
+
+bool work_stealing_pool::pop_local(size_t index, std::function<void()>& task)
+{
+  worker_queue& queue = *queues[index];
+  std::lock_guard<std::mutex> lock(queue.mutex);
+  if (queue.tasks.empty())
+  {
+    return false;
+  }
+  task = std::move(queue.tasks.back());
+  queue.tasks.pop_back();
+  return true;
+}
+
+bool work_stealing_pool::steal(size_t thief, std::function<void()>& task)
+{
+  for (size_t i = 1; i < queues.size(); i++)
+  {
+    worker_queue& queue = *queues[(thief + i) % queues.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.tasks.empty())
+    {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads, each with its own task deque.
+// Workers take their newest task first and, when out of work, steal the oldest task of another worker.
+// Tasks submitted from a worker go to that worker's deque, others are spread round-robin.
+// Meant for coarse tasks (whole solvers): deques are guarded by a mutex each, not lock-free.
+class work_stealing_pool
+{
+public:
+  // 0 threads means one per hardware thread.
+  explicit work_stealing_pool(size_t num_threads = 0);
+  // Finishes all submitted tasks first.
+  ~work_stealing_pool();
+
+  work_stealing_pool(work_stealing_pool const&) = delete;
+  work_stealing_pool& operator=(work_stealing_pool const&) = delete;
+
+  void submit(std::function<void()> task);
+
+  // Blocks until every task submitted so far, and every task they submitted, has finished.
+  void wait();
+
+  size_t num_threads() const
+  {
+    return threads.size();
+  }
+
+private:
+  struct worker_queue
+  {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  void worker_loop(size_t index);
+  bool pop_local(size_t index, std::function<void()>& task);
+  bool steal(size_t thief, std::function<void()>& task);
+
+  std::vector<std::unique_ptr<worker_queue>> queues;
+  std::vector<std::thread> threads;
+  std::atomic<size_t> next_queue{ 0 };
+
+  // Guards the counters below, workers sleep on it when every deque is empty.
+  std::mutex mutex;
+  std::condition_variable work_available;
+  std::condition_variable all_done;
+  // Tasks sitting in deques.
+  size_t num_queued = 0;
+  // Tasks submitted and not finished yet.
+  size_t num_pending = 0;
+  bool stopping = false;
+};
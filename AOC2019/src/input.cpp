@@ -0,0 +1,195 @@
+#include <stdint.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "input.hpp"
+
+namespace
+{
+  size_t page_size()
+  {
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+  }
+
+  void unmap_file(void* view, size_t size)
+  {
+#if defined(_WIN32)
+    (void)size;
+    UnmapViewOfFile(view);
+#else
+    munmap(view, size);
+#endif
+  }
+}
+
+input_text::input_text(input_text&& other)
+{
+  *this = std::move(other);
+}
+
+input_text& input_text::operator=(input_text&& other)
+{
+  if (this != &other)
+  {
+    release();
+    text = other.text;
+    length = other.length;
+    view = other.view;
+    copy = std::move(other.copy);
+    other.text = nullptr;
+    other.length = 0;
+    other.view = nullptr;
+  }
+  return *this;
+}
+
+input_text::~input_text()
+{
+  release();
+}
+
+void input_text::release()
+{
+  if (view != nullptr)
+  {
+    unmap_file(view, length);
+  }
+  text = nullptr;
+  length = 0;
+  view = nullptr;
+  copy.clear();
+}
+
+input_text input_text::from_stream(FILE* stream)
+{
+  input_text ret;
+  char chunk[64 * 1024];
+  size_t count;
+  while ((count = fread(chunk, 1, sizeof(chunk), stream)) > 0)
+  {
+    ret.copy.insert(ret.copy.end(), chunk, chunk + count);
+  }
+  if (ferror(stream))
+  {
+    return input_text();
+  }
+  ret.length = ret.copy.size();
+  ret.copy.push_back('\0');
+  ret.text = ret.copy.data();
+  return ret;
+}
+
+input_text input_text::from_file(const char* path)
+{
+  return open(path, false);
+}
+
+input_text input_text::from_binary_file(const char* path)
+{
+  return open(path, true);
+}
+
+// The file is opened once and read as a stream if it can't be mapped, pipes can't be reopened.
+input_text input_text::open(const char* path, bool binary)
+{
+#if defined(_WIN32)
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    return input_text();
+  }
+  LARGE_INTEGER file_size;
+  if (GetFileType(file) == FILE_TYPE_DISK && GetFileSizeEx(file, &file_size) &&
+      file_size.QuadPart > 0 && (uint64_t)file_size.QuadPart % page_size() != 0)
+  {
+    const size_t size = (size_t)file_size.QuadPart;
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (mapping != nullptr)
+    {
+      CloseHandle(mapping);
+    }
+    // Text mode used to turn CRLF into LF, such files still go through it.
+    if (view != nullptr && (binary || memchr(view, '\r', size) == nullptr))
+    {
+      CloseHandle(file);
+      input_text ret;
+      ret.view = view;
+      ret.text = (const char*)view;
+      ret.length = size;
+      return ret;
+    }
+    if (view != nullptr)
+    {
+      UnmapViewOfFile(view);
+    }
+  }
+  const int fd = _open_osfhandle((intptr_t)file, _O_RDONLY | (binary ? _O_BINARY : _O_TEXT));
+  if (fd < 0)
+  {
+    CloseHandle(file);
+    return input_text();
+  }
+  FILE* stream = _fdopen(fd, binary ? "rb" : "r");
+  if (stream == nullptr)
+  {
+    _close(fd);
+    return input_text();
+  }
+#else
+  (void)binary;
+  const int fd = ::open(path, O_RDONLY);
+  if (fd < 0)
+  {
+    return input_text();
+  }
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 && (size_t)st.st_size % page_size() != 0)
+  {
+    const size_t size = (size_t)st.st_size;
+    void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view != MAP_FAILED)
+    {
+      close(fd);
+      input_text ret;
+      ret.view = view;
+      ret.text = (const char*)view;
+      ret.length = size;
+      return ret;
+    }
+  }
+  FILE* stream = fdopen(fd, "r");
+  if (stream == nullptr)
+  {
+    close(fd);
+    return input_text();
+  }
+#endif
+  file_ptr file{ stream };
+  return from_stream(file.get());
+}
+
+input_text read_input(int day)
+{
+  char input_filename[32] = {};
+  sprintf(input_filename, "inputs/input%d.txt", day);
+  return input_text::from_file(input_filename);
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <stddef.h>
+#include <stdio.h>
+#include <memory>
+#include <vector>
+
+class file_ptr : public std::unique_ptr<FILE, decltype(&fclose)>
+{
+  using base_class = std::unique_ptr<FILE, decltype(&fclose)>;
+
+public:
+  file_ptr() : base_class{ nullptr, &fclose }
+  {
+  }
+  file_ptr(FILE* file) : base_class{ file, &fclose }
+  {
+  }
+  ~file_ptr() = default;
+};
+
+// Puzzle input as a NUL-terminated string.
+// Regular files are mapped read-only and used in place: the zero fill after the end of the last page
+// provides the terminator. Pipes, stdin and files that end exactly on a page boundary are read into
+// a buffer instead, as are files with CRLF line ends on Windows, which text mode used to translate.
+class input_text
+{
+public:
+  input_text() = default;
+  input_text(input_text&& other);
+  input_text& operator=(input_text&& other);
+  input_text(input_text const&) = delete;
+  input_text& operator=(input_text const&) = delete;
+  ~input_text();
+
+  // Reads the whole stream.
+  static input_text from_stream(FILE* stream);
+  static input_text from_file(const char* path);
+  // Without newline translation on Windows, for files that aren't text.
+  static input_text from_binary_file(const char* path);
+
+  explicit operator bool() const
+  {
+    return text != nullptr;
+  }
+
+  const char* get() const
+  {
+    return text;
+  }
+
+  // Excluding the terminator.
+  size_t size() const
+  {
+    return length;
+  }
+
+private:
+  static input_text open(const char* path, bool binary);
+  void release();
+
+  const char* text = nullptr;
+  size_t length = 0;
+  // Mapped view, or null if the text lives in 'copy'.
+  void* view = nullptr;
+  std::vector<char> copy;
+};
+
+// Contents of inputs/input<day>.txt, empty if it can't be read.
+input_text read_input(int day);
@@ -1,43 +1,123 @@
 #include <stdio.h>
-#include <memory>
+#include <string.h>
+#include <string>
+#include <vector>
 
+#include "bench.hpp"
+#include "input.hpp"
+#include "runner.hpp"
 #include "solver.hpp"
+#include "common/intcode_machine.hpp"
+#include "common/intcode_translator.hpp"
 
-class file_ptr : public std::unique_ptr<FILE, decltype(&fclose)>
+// "19" selects both parts of day 19, "19:2" only the second.
+static bool parse_task_ids(const char* arg, std::vector<task_id>& tasks)
 {
-  using base_class = std::unique_ptr<FILE, decltype(&fclose)>;
+  int day = 0;
+  int subtask = 0;
+  const int num_fields = sscanf(arg, "%d:%d", &day, &subtask);
+  if (num_fields < 1 || day < 1 || (num_fields == 2 && subtask != 1 && subtask != 2))
+  {
+    return false;
+  }
+  for (int s = 1; s <= 2; s++)
+  {
+    if (num_fields == 1 || s == subtask)
+    {
+      tasks.push_back(task_id{ day, s });
+    }
+  }
+  return true;
+}
 
-public:
-  file_ptr() : base_class{ nullptr, &fclose }
+// Writes the Intcode program of the day as C++ to src/generated, for the TranslateIntcode target.
+static int translate(int day)
+{
+  input_text input_buffer = read_input(day);
+  if (!input_buffer)
   {
+    return 1;
   }
-  file_ptr(FILE* file) : base_class{ file, &fclose }
+
+  char output_filename[64] = {};
+  sprintf(output_filename, "src/generated/intcode_day%d.cpp", day);
+  file_ptr output_file{ fopen(output_filename, "w") };
+  if (!output_file)
   {
+    return 1;
   }
-  ~file_ptr() = default;
-};
+
+  translate_intcode_program(read_intcode_program(input_buffer.get()), output_file.get());
+  return 0;
+}
 
 int main(int argc, char** argv)
 {
-  // Arg 1 - day (1-25)
-  // Arg 2 - subtask (1, 2)
+  // Arg 1 - day (1-25), "translate" or "--bench"
+  // Arg 2 - subtask (1, 2), or day to translate
+  // Arg 3 - optional "-" to read the input from stdin instead of inputs/input<day>.txt
+  // "--bench [day [subtask]]" benchmarks every task with an input, or only the given ones.
+  // "--bench hash" compares the hashes of grid coordinates instead.
+  // "--parallel [day[:subtask]...]" solves the given tasks at once, every task with an input by default.
+  if (argc >= 3 && strcmp(argv[1], "--bench") == 0 && strcmp(argv[2], "hash") == 0)
+  {
+    return run_hash_benchmark();
+  }
+  if (argc >= 2 && strcmp(argv[1], "--bench") == 0)
+  {
+    return run_benchmarks(argc > 2 ? atoi(argv[2]) : 0, argc > 3 ? atoi(argv[3]) : 0);
+  }
+
+  if (argc >= 2 && strcmp(argv[1], "--parallel") == 0)
+  {
+    std::vector<task_id> tasks;
+    for (int i = 2; i < argc; i++)
+    {
+      if (!parse_task_ids(argv[i], tasks))
+      {
+        return 1;
+      }
+    }
+    if (tasks.empty())
+    {
+      for (solver_info const& solver : all_solvers())
+      {
+        file_ptr input_file{ fopen(("inputs/input" + std::to_string(solver.day) + ".txt").c_str(), "r") };
+        if (input_file && !solver.interactive)
+        {
+          tasks.push_back(task_id{ solver.day, solver.subtask });
+        }
+      }
+    }
+    return run_parallel(tasks);
+  }
+
   if (argc < 3)
   {
     return 1;
   }
 
+  if (strcmp(argv[1], "translate") == 0)
+  {
+    return translate(atoi(argv[2]));
+  }
+
   int day = atoi(argv[1]);
   int subtask = atoi(argv[2]);
-  std::unique_ptr<base_solver> solver = create_solver(day, subtask);
+  solver_info const* solver = find_solver(day, subtask);
   if (!solver)
   {
     return 1;
   }
 
-  char input_filename[32] = {};
-  sprintf(input_filename, "inputs/input%d.txt", day);
-  file_ptr input_file{ fopen(input_filename, "r") };
-  if (!input_file)
+  const bool input_from_stdin = argc > 3 && strcmp(argv[3], "-") == 0;
+  if (input_from_stdin && solver->interactive)
+  {
+    // stdin carries the commands.
+    return 1;
+  }
+  input_text input_buffer = input_from_stdin ? input_text::from_stream(stdin) : read_input(day);
+  if (!input_buffer)
   {
     return 1;
   }
@@ -50,27 +130,8 @@ int main(int argc, char** argv)
     return 1;
   }
 
-  long input_length = 0;
-  {
-    fseek(input_file.get(), 0, SEEK_END);
-    input_length = ftell(input_file.get());
-    fseek(input_file.get(), 0, SEEK_SET);
-  }
-
-  std::unique_ptr<char[]> input_buffer{ new char[input_length + 1] };
-  {
-    char* buf = input_buffer.get();
-    while (fgets(buf, input_length + 1, input_file.get()))
-    {
-      buf += strlen(buf);
-    }
-  }
-
-  std::unique_ptr<char[]> output_buffer{ new char[8 * 1024 * 1024] };
-  output_buffer[0] = '\0';
-
-  solver->solve(input_buffer.get(), output_buffer.get());
-
-  fputs(output_buffer.get(), output_file.get());
-  return 0;
+  output_sink output{ output_file.get() };
+  solver->solve(input_buffer.get(), output);
+  output.flush();
+  return output.failed() ? 1 : 0;
 }
@@ -0,0 +1,96 @@
+#include <stdarg.h>
+#include <string.h>
+#include <vector>
+
+#include "output_sink.hpp"
+
+output_sink::output_sink(FILE* file) : file{ file }
+{
+}
+
+output_sink::output_sink(std::string& text) : text{ &text }
+{
+}
+
+output_sink::~output_sink()
+{
+  flush();
+}
+
+void output_sink::append(const char* text, size_t length)
+{
+  if (length > capacity - used)
+  {
+    flush();
+    // Doesn't fit even in an empty buffer, no point copying it.
+    if (length > capacity)
+    {
+      write(text, length);
+      return;
+    }
+  }
+  memcpy(buffer + used, text, length);
+  used += length;
+}
+
+void output_sink::append(const char* text)
+{
+  append(text, strlen(text));
+}
+
+int output_sink::print(const char* format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  va_list retry_args;
+  va_copy(retry_args, args);
+  // Formats straight into the free part of the buffer, which is enough nearly every time.
+  const int length = vsnprintf(buffer + used, capacity - used, format, args);
+  va_end(args);
+  if (length < 0)
+  {
+    va_end(retry_args);
+    return 0;
+  }
+  if ((size_t)length < capacity - used)
+  {
+    used += length;
+  }
+  else if ((size_t)length < capacity)
+  {
+    flush();
+    vsnprintf(buffer, capacity, format, retry_args);
+    used = length;
+  }
+  else
+  {
+    std::vector<char> large(length + 1);
+    vsnprintf(large.data(), large.size(), format, retry_args);
+    flush();
+    write(large.data(), length);
+  }
+  va_end(retry_args);
+  return length;
+}
+
+void output_sink::flush()
+{
+  write(buffer, used);
+  used = 0;
+}
+
+void output_sink::write(const char* text, size_t length)
+{
+  if (length == 0)
+  {
+    return;
+  }
+  if (file != nullptr)
+  {
+    write_failed = write_failed || fwrite(text, 1, length, file) != length;
+  }
+  else if (this->text != nullptr)
+  {
+    this->text->append(text, length);
+  }
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <stddef.h>
+#include <stdio.h>
+#include <string>
+
+#if defined(__GNUC__)
+#define OUTPUT_SINK_PRINTF_FORMAT __attribute__((format(printf, 2, 3)))
+#else
+#define OUTPUT_SINK_PRINTF_FORMAT
+#endif
+
+// Where a solver writes its answer.
+// Text collects in a small fixed buffer that is handed on whenever it fills up, so memory stays
+// constant however much a solver prints, and no write can run past the end of anything.
+// The destination is a file, a string, or nothing at all (benchmarks).
+class output_sink
+{
+public:
+  // Discards everything.
+  output_sink() = default;
+  // Writes to 'file', which must outlive the sink.
+  explicit output_sink(FILE* file);
+  // Appends to 'text', which must outlive the sink.
+  explicit output_sink(std::string& text);
+  output_sink(output_sink const&) = delete;
+  output_sink& operator=(output_sink const&) = delete;
+  // Flushes.
+  ~output_sink();
+
+  void put(char c)
+  {
+    if (used == capacity)
+    {
+      flush();
+    }
+    buffer[used++] = c;
+  }
+
+  void append(const char* text, size_t length);
+  void append(const char* text);
+
+  // printf into the sink, returns the number of characters written.
+  int print(const char* format, ...) OUTPUT_SINK_PRINTF_FORMAT;
+
+  // Hands the buffered text to the destination.
+  void flush();
+
+  // True once a write to the file failed.
+  bool failed() const
+  {
+    return write_failed;
+  }
+
+private:
+  static const size_t capacity = 4096;
+
+  void write(const char* text, size_t length);
+
+  FILE* file = nullptr;
+  std::string* text = nullptr;
+  bool write_failed = false;
+  size_t used = 0;
+  char buffer[capacity];
+};
+
+#undef OUTPUT_SINK_PRINTF_FORMAT
@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <direct.h>
+#include <process.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "parse_cache.hpp"
+
+namespace
+{
+  const char cache_directory[] = "cache";
+  const char file_magic[8] = { 'A', 'O', 'C', 'P', 'A', 'R', 'S', 'E' };
+  const uint32_t file_version = 1;
+
+  // Precedes the artifact, 64 bytes so the artifact starts 8-byte aligned.
+  struct file_header
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t input_hash;
+    uint64_t input_size;
+    uint64_t artifact_size;
+    char tag[24];
+  };
+  static_assert(sizeof(file_header) == 64, "the artifact must stay aligned");
+
+  bool requested_by_environment()
+  {
+    const char* value = getenv("PARSE_CACHE");
+    return value == nullptr || strcmp(value, "0") != 0;
+  }
+
+  // 64-bit hash of 'size' bytes, eight bytes per step.
+  uint64_t hash_bytes(const char* data, size_t size)
+  {
+    const uint64_t multiplier = 0x9e3779b97f4a7c15ull;
+    uint64_t h = size * multiplier;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+      uint64_t word;
+      memcpy(&word, data + i, 8);
+      h = (h ^ word) * multiplier;
+      h ^= h >> 29;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, data + i, size - i);
+    h = (h ^ tail) * multiplier;
+    h ^= h >> 32;
+    h *= 0xd6e8feb86659fd93ull;
+    h ^= h >> 32;
+    return h;
+  }
+
+  void fill_header(file_header& header, const char* tag, const char* input, size_t artifact_size)
+  {
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, file_magic, sizeof(file_magic));
+    header.version = file_version;
+    header.header_size = sizeof(file_header);
+    header.input_size = strlen(input);
+    header.input_hash = hash_bytes(input, (size_t)header.input_size);
+    header.artifact_size = artifact_size;
+    strncpy(header.tag, tag, sizeof(header.tag) - 1);
+  }
+
+  void cache_file_path(char* path, size_t size, file_header const& header)
+  {
+    snprintf(path, size, "%s/%s-%016llx.bin", cache_directory, header.tag, (unsigned long long)header.input_hash);
+  }
+
+  void make_cache_directory()
+  {
+#if defined(_WIN32)
+    _mkdir(cache_directory);
+#else
+    mkdir(cache_directory, 0777);
+#endif
+  }
+
+  int process_id()
+  {
+#if defined(_WIN32)
+    return _getpid();
+#else
+    return (int)getpid();
+#endif
+  }
+
+  bool replace_file(const char* from, const char* to)
+  {
+#if defined(_WIN32)
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(from, to) == 0;
+#endif
+  }
+}
+
+bool parse_cache_enabled()
+{
+  static const bool enabled = requested_by_environment();
+  return enabled;
+}
+
+parse_cache_entry::parse_cache_entry(input_text&& file) : file{ std::move(file) }
+{
+  payload = this->file.get() + sizeof(file_header);
+  payload_size = this->file.size() - sizeof(file_header);
+}
+
+parse_cache_entry load_parsed_input(const char* tag, const char* input)
+{
+  file_header expected;
+  fill_header(expected, tag, input, 0);
+  char path[128];
+  cache_file_path(path, sizeof(path), expected);
+
+  input_text file = input_text::from_binary_file(path);
+  if (!file || file.size() < sizeof(file_header))
+  {
+    return parse_cache_entry();
+  }
+  file_header header;
+  memcpy(&header, file.get(), sizeof(header));
+  expected.artifact_size = header.artifact_size;
+  if (memcmp(&header, &expected, sizeof(header)) != 0 || header.artifact_size != file.size() - sizeof(file_header))
+  {
+    return parse_cache_entry();
+  }
+  return parse_cache_entry(std::move(file));
+}
+
+void store_parsed_input(const char* tag, const char* input, parse_cache_writer const& artifact)
+{
+  static std::atomic<unsigned> num_stored{ 0 };
+
+  file_header header;
+  fill_header(header, tag, input, artifact.bytes().size());
+  char path[128];
+  cache_file_path(path, sizeof(path), header);
+  char temporary_path[160];
+  snprintf(temporary_path, sizeof(temporary_path), "%s.%d-%u.tmp", path, process_id(), num_stored.fetch_add(1));
+
+  make_cache_directory();
+  bool written = false;
+  {
+    file_ptr file{ fopen(temporary_path, "wb") };
+    written = file &&
+      fwrite(&header, sizeof(header), 1, file.get()) == 1 &&
+      fwrite(artifact.bytes().data(), 1, artifact.bytes().size(), file.get()) == artifact.bytes().size() &&
+      fclose(file.release()) == 0;
+  }
+  if (!written || !replace_file(temporary_path, path))
+  {
+    remove(temporary_path);
+  }
+}
@@ -0,0 +1,204 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "input.hpp"
+
+// On-disk cache of parsed puzzle inputs.
+//
+// A parser that is slow compared to reading its result back (Intcode images, maps with derived
+// lookup tables, ...) can store what it built under a tag in cache/<tag>-<input hash>.bin,
+// and later runs on the same input read that file instead of parsing again.
+// Entries are keyed by a hash of the whole input text, so editing an input simply misses,
+// and the header repeats hash, size and tag so that stale or damaged files are never used.
+// Change the tag when the layout of an artifact changes.
+//
+// Artifacts are flat binary: scalars and arrays of trivially copyable values, arrays 8-byte
+// aligned so they can be used in place of the mapped file.
+// Set PARSE_CACHE=0 to neither read nor write the cache.
+
+bool parse_cache_enabled();
+
+class parse_cache_writer
+{
+public:
+  template <typename T>
+  void write(T const& value)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "cache artifacts are copied byte by byte");
+    write_bytes(&value, sizeof(value));
+  }
+
+  template <typename T>
+  void write_array(T const* values, size_t count)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "cache artifacts are copied byte by byte");
+    write<uint64_t>(count);
+    align();
+    write_bytes(values, count * sizeof(T));
+  }
+
+  void write_string(std::string const& s)
+  {
+    write_array(s.data(), s.size());
+  }
+
+  std::vector<char> const& bytes() const
+  {
+    return buffer;
+  }
+
+private:
+  void write_bytes(const void* data, size_t size)
+  {
+    buffer.insert(buffer.end(), (const char*)data, (const char*)data + size);
+  }
+
+  void align()
+  {
+    buffer.resize((buffer.size() + 7) & ~(size_t)7);
+  }
+
+  std::vector<char> buffer;
+};
+
+// Reads an artifact back in the order it was written.
+// Reads are bounds checked: past the end, or on an array that doesn't fit, the reader fails
+// for good and returns zeroes and empty arrays, so loaders only need to check ok() at the end.
+class parse_cache_reader
+{
+public:
+  parse_cache_reader(const char* data, size_t size) : begin{ data }, cursor{ data }, end{ data + size }
+  {
+  }
+
+  template <typename T>
+  T read()
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "cache artifacts are copied byte by byte");
+    T value{};
+    if (!failed && (size_t)(end - cursor) >= sizeof(T))
+    {
+      memcpy(&value, cursor, sizeof(T));
+      cursor += sizeof(T);
+    }
+    else
+    {
+      failed = true;
+    }
+    return value;
+  }
+
+  // Points into the cache file, valid as long as the entry it came from.
+  template <typename T>
+  T const* read_array(size_t& count)
+  {
+    static_assert(std::is_trivially_copyable<T>::value, "cache artifacts are copied byte by byte");
+    const uint64_t n = read<uint64_t>();
+    const size_t padding = (size_t)(-(cursor - begin) & 7);
+    if (failed || (size_t)(end - cursor) < padding || n > (size_t)(end - cursor - padding) / sizeof(T))
+    {
+      failed = true;
+      count = 0;
+      return nullptr;
+    }
+    cursor += padding;
+    T const* values = (T const*)cursor;
+    cursor += n * sizeof(T);
+    count = (size_t)n;
+    return values;
+  }
+
+  std::string read_string()
+  {
+    size_t length = 0;
+    const char* s = read_array<char>(length);
+    return std::string(s != nullptr ? s : "", length);
+  }
+
+  // True if every read so far succeeded, loops over counts read from the file should check it.
+  bool good() const
+  {
+    return !failed;
+  }
+
+  // True if every read so far succeeded and all of the artifact was read.
+  bool ok() const
+  {
+    return !failed && cursor == end;
+  }
+
+private:
+  const char* begin;
+  const char* cursor;
+  const char* end;
+  bool failed = false;
+};
+
+// Cached artifact, mapped while the entry lives.
+class parse_cache_entry
+{
+public:
+  parse_cache_entry() = default;
+  explicit parse_cache_entry(input_text&& file);
+
+  explicit operator bool() const
+  {
+    return payload != nullptr;
+  }
+
+  parse_cache_reader reader() const
+  {
+    return parse_cache_reader(payload, payload_size);
+  }
+
+private:
+  input_text file;
+  const char* payload = nullptr;
+  size_t payload_size = 0;
+};
+
+// Artifact 'tag' of 'input', empty if there is none for this exact input.
+parse_cache_entry load_parsed_input(const char* tag, const char* input);
+
+// Saves 'artifact' as 'tag' of 'input'.
+// Written to a temporary file and renamed into place, so concurrent runs never see half a file.
+// Failures are ignored, the cache is only a shortcut.
+void store_parsed_input(const char* tag, const char* input, parse_cache_writer const& artifact);
+
+// Result of 'parse(input)', read back with 'load' from the cache when possible,
+// otherwise parsed and stored with 'save' for the next run.
+//   parse: T(const char* input)
+//   save:  void(parse_cache_writer&, T const&)
+//   load:  T(parse_cache_reader&)
+template <typename parse_func, typename save_func, typename load_func>
+auto cached_parse(const char* tag, const char* input, parse_func parse, save_func save, load_func load) -> decltype(parse(input))
+{
+  if (!parse_cache_enabled())
+  {
+    return parse(input);
+  }
+
+  {
+    parse_cache_entry entry = load_parsed_input(tag, input);
+    if (entry)
+    {
+      parse_cache_reader reader = entry.reader();
+      auto value = load(reader);
+      if (reader.ok())
+      {
+        return value;
+      }
+    }
+  }
+
+  auto value = parse(input);
+  parse_cache_writer writer;
+  save(writer, value);
+  store_parsed_input(tag, input, writer);
+  return value;
+}
@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+#include "input.hpp"
+#include "runner.hpp"
+#include "solver.hpp"
+#include "common/work_stealing_pool.hpp"
+
+namespace
+{
+  struct task_result
+  {
+    task_id id;
+    bool solved = false;
+    double ms = 0.0;
+    std::string output;
+  };
+
+  void solve_task(task_result& result)
+  {
+    solver_info const* solver = find_solver(result.id.day, result.id.subtask);
+    if (!solver || solver->interactive)
+    {
+      return;
+    }
+
+    input_text input_buffer = read_input(result.id.day);
+    if (!input_buffer)
+    {
+      return;
+    }
+
+    // Kept whole until every task of the day is done, files list the outputs in subtask order.
+    output_sink output{ result.output };
+    const auto start = std::chrono::steady_clock::now();
+    solver->solve(input_buffer.get(), output);
+    output.flush();
+    result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    result.solved = true;
+  }
+
+  bool write_output(int day, std::string const& text)
+  {
+    char output_filename[32] = {};
+    sprintf(output_filename, "outputs/output%d.txt", day);
+    file_ptr output_file{ fopen(output_filename, "w") };
+    return output_file && fputs(text.c_str(), output_file.get()) >= 0;
+  }
+}
+
+int run_parallel(std::vector<task_id> tasks)
+{
+  auto less = [](task_id a, task_id b) { return a.day != b.day ? a.day < b.day : a.subtask < b.subtask; };
+  auto same = [](task_id a, task_id b) { return a.day == b.day && a.subtask == b.subtask; };
+  std::sort(tasks.begin(), tasks.end(), less);
+  tasks.erase(std::unique(tasks.begin(), tasks.end(), same), tasks.end());
+
+  std::vector<task_result> results(tasks.size());
+  const auto start = std::chrono::steady_clock::now();
+  {
+    work_stealing_pool pool;
+    for (size_t i = 0; i < tasks.size(); i++)
+    {
+      results[i].id = tasks[i];
+      task_result* result = &results[i];
+      pool.submit([result]() { solve_task(*result); });
+    }
+    pool.wait();
+  }
+  const double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  bool all_solved = true;
+  for (size_t first = 0; first < results.size(); )
+  {
+    size_t last = first;
+    std::string text;
+    for (; last < results.size() && results[last].id.day == results[first].id.day; last++)
+    {
+      task_result const& result = results[last];
+      if (result.solved)
+      {
+        text += text.empty() ? "" : "\n";
+        text += result.output;
+        printf("%d\t%d\t%.3f\n", result.id.day, result.id.subtask, result.ms);
+      }
+      else
+      {
+        printf("%d\t%d\tfailed\n", result.id.day, result.id.subtask);
+        all_solved = false;
+      }
+    }
+    if (!text.empty() && !write_output(results[first].id.day, text))
+    {
+      all_solved = false;
+    }
+    first = last;
+  }
+  printf("total\t\t%.3f\n", total_ms);
+  return all_solved ? 0 : 1;
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <vector>
+
+struct task_id
+{
+  int day;
+  int subtask;
+};
+
+// Solves 'tasks' concurrently on a work-stealing pool, each into its own output string.
+// When all are done, writes outputs/output<day>.txt per day, holding the outputs of that day's
+// tasks in subtask order, one per line, and prints a "day part ms" line per task to stdout.
+// Files and summary don't depend on scheduling. Returns 0 if every task was solved.
+int run_parallel(std::vector<task_id> tasks);
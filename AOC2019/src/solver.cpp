@@ -1,43 +1,100 @@
+#include <array>
+#include <utility>
+
 #include "solver.hpp"
+#include "common/intcode_machine.hpp"
 
-template <int day>
-static inline std::unique_ptr<base_solver> create_solver_for_day(int subtask)
+namespace
 {
-  switch (subtask)
+  struct puzzle
+  {
+    int day;
+    const char* name;
+    input_kind input;
+    // Per subtask.
+    bool interactive[2];
+    // For text days with a separate parser.
+    parse_function parse;
+  };
+
+  // One entry per day, consecutive from the first day that has solvers.
+  constexpr puzzle puzzles[] =
+  {
+    { 3, "Crossed Wires", input_kind::text, { false, false }, nullptr },
+    { 4, "Secure Container", input_kind::text, { false, false }, nullptr },
+    { 5, "Sunny with a Chance of Asteroids", input_kind::intcode, { false, false }, nullptr },
+    { 6, "Universal Orbit Map", input_kind::text, { false, false }, nullptr },
+    { 7, "Amplification Circuit", input_kind::intcode, { false, false }, nullptr },
+    { 8, "Space Image Format", input_kind::text, { false, false }, nullptr },
+    { 9, "Sensor Boost", input_kind::intcode, { false, false }, nullptr },
+    { 10, "Monitoring Station", input_kind::text, { false, false }, nullptr },
+    { 11, "Space Police", input_kind::intcode, { false, false }, nullptr },
+    { 12, "The N-Body Problem", input_kind::text, { false, false }, nullptr },
+    { 13, "Care Package", input_kind::intcode, { false, false }, nullptr },
+    { 14, "Space Stoichiometry", input_kind::text, { false, false }, &parse_input<14> },
+    { 15, "Oxygen System", input_kind::intcode, { false, false }, nullptr },
+    { 16, "Flawed Frequency Transmission", input_kind::text, { false, false }, nullptr },
+    { 17, "Set and Forget", input_kind::intcode, { false, false }, nullptr },
+    { 18, "Many-Worlds Interpretation", input_kind::text, { false, false }, &parse_input<18> },
+    { 19, "Tractor Beam", input_kind::intcode, { false, false }, nullptr },
+    { 20, "Donut Maze", input_kind::text, { false, false }, &parse_input<20> },
+    { 21, "Springdroid Adventure", input_kind::intcode, { false, false }, nullptr },
+    { 22, "Slam Shuffle", input_kind::text, { false, false }, nullptr },
+    { 23, "Category Six", input_kind::intcode, { false, false }, nullptr },
+    { 24, "Planet of Discord", input_kind::text, { false, false }, nullptr },
+    { 25, "Cryostasis", input_kind::intcode, { true, false }, nullptr },
+  };
+
+  constexpr int first_day = puzzles[0].day;
+  constexpr int num_days = sizeof(puzzles) / sizeof(puzzles[0]);
+
+  constexpr bool days_are_consecutive()
+  {
+    for (int i = 0; i < num_days; i++)
+    {
+      if (puzzles[i].day != first_day + i)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+  static_assert(days_are_consecutive(), "find_solver() indexes the registry by day");
+
+  // The parser of every Intcode day.
+  void parse_intcode(const char* input)
+  {
+    read_intcode_program(input);
+  }
+
+  template <int day, int subtask>
+  constexpr solver_info make_solver_info()
+  {
+    return solver_info{ day, subtask, puzzles[day - first_day].name, puzzles[day - first_day].input,
+      puzzles[day - first_day].interactive[subtask - 1], &solver<day, subtask>::solve,
+      puzzles[day - first_day].input == input_kind::intcode ? &parse_intcode : puzzles[day - first_day].parse };
+  }
+
+  // Entry i is subtask i % 2 + 1 of day first_day + i / 2.
+  template <int... indices>
+  constexpr std::array<solver_info, sizeof...(indices)> make_registry(std::integer_sequence<int, indices...>)
   {
-    case 1: return std::unique_ptr<base_solver>(new solver<day, 1>());
-    case 2: return std::unique_ptr<base_solver>(new solver<day, 2>());
-    default: return nullptr;
+    return { { make_solver_info<first_day + indices / 2, indices % 2 + 1>()... } };
   }
+
+  constexpr std::array<solver_info, 2 * num_days> registry = make_registry(std::make_integer_sequence<int, 2 * num_days>());
 }
 
-std::unique_ptr<base_solver> create_solver(int day, int subtask)
+solver_range all_solvers()
 {
-  switch (day)
+  return solver_range{ registry.data(), registry.data() + registry.size() };
+}
+
+solver_info const* find_solver(int day, int subtask)
+{
+  if (day < first_day || day >= first_day + num_days || subtask < 1 || subtask > 2)
   {
-    case 3: return create_solver_for_day<3>(subtask);
-    case 4: return create_solver_for_day<4>(subtask);
-    case 5: return create_solver_for_day<5>(subtask);
-    case 6: return create_solver_for_day<6>(subtask);
-    case 7: return create_solver_for_day<7>(subtask);
-    case 8: return create_solver_for_day<8>(subtask);
-    case 9: return create_solver_for_day<9>(subtask);
-    case 10: return create_solver_for_day<10>(subtask);
-    case 11: return create_solver_for_day<11>(subtask);
-    case 12: return create_solver_for_day<12>(subtask);
-    case 13: return create_solver_for_day<13>(subtask);
-    case 14: return create_solver_for_day<14>(subtask);
-    case 15: return create_solver_for_day<15>(subtask);
-    case 16: return create_solver_for_day<16>(subtask);
-    case 17: return create_solver_for_day<17>(subtask);
-    case 18: return create_solver_for_day<18>(subtask);
-    case 19: return create_solver_for_day<19>(subtask);
-    case 20: return create_solver_for_day<20>(subtask);
-    case 21: return create_solver_for_day<21>(subtask);
-    case 22: return create_solver_for_day<22>(subtask);
-    case 23: return create_solver_for_day<23>(subtask);
-    case 24: return create_solver_for_day<24>(subtask);
-    case 25: return create_solver_for_day<25>(subtask);
-    default: return nullptr;
+    return nullptr;
   }
-}
\ No newline at end of file
+  return &registry[(day - first_day) * 2 + subtask - 1];
+}
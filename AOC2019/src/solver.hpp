@@ -1,17 +1,62 @@
 #pragma once
-#include <memory>
+#include <stddef.h>
 
-class base_solver
+#include "output_sink.hpp"
+
+template <int day, int subtask>
+class solver
 {
 public:
-  virtual void solve(const char* input, char* output) = 0;
+  static void solve(const char* input, output_sink& output);
 };
 
-template <int day, int subtask>
-class solver : public base_solver
+enum class input_kind
 {
-public:
-  void solve(const char* input, char* output) override;
+  text,
+  intcode,
+};
+
+using solve_function = void (*)(const char* input, output_sink& output);
+using parse_function = void (*)(const char* input);
+
+// Runs the parser of a day's solvers on its own, without the parse cache, and drops the result.
+// Only days listed with one in solver.cpp define it, for timing the parse apart from the solve.
+template <int day>
+void parse_input(const char* input);
+
+struct solver_info
+{
+  int day;
+  int subtask;
+  // Puzzle title.
+  const char* name;
+  input_kind input;
+  // Reads commands from stdin while it runs, so it needs a terminal and can't be benchmarked.
+  bool interactive;
+  // solver<day, subtask>::solve
+  solve_function solve;
+  // parse_input<day>, read_intcode_program() for Intcode days, null if the parse can't be
+  // separated from the solve.
+  parse_function parse;
 };
 
-std::unique_ptr<base_solver> create_solver(int day, int subtask);
+// Every solver, by day then subtask.
+struct solver_range
+{
+  solver_info const* first;
+  solver_info const* last;
+
+  solver_info const* begin() const
+  {
+    return first;
+  }
+  solver_info const* end() const
+  {
+    return last;
+  }
+};
+
+solver_range all_solvers();
+
+// Null if there is no such solver.
+solver_info const* find_solver(int day, int subtask);
@@ -13,11 +13,11 @@ namespace
   // Put solution helpers here
 } // namespace
 
-void solver<DAY, 1>::solve(const char* input, char* output)
+void solver<DAY, 1>::solve(const char* input, output_sink& output)
 {
 }
 
-void solver<DAY, 2>::solve(const char* input, char* output)
+void solver<DAY, 2>::solve(const char* input, output_sink& output)
 {
 }
 */
\ No newline at end of file
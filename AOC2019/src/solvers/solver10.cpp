@@ -135,7 +135,7 @@ static int count_visible_asteroids(map const& base_map, std::vector<vec2> const&
 }
 
 }
-void solver<DAY, 1>::solve(const char* input, char* output)
+void solver<DAY, 1>::solve(const char* input, output_sink& output)
 {
   map base_map = read_map(input);
   std::vector<vec2> asteroids = get_asteroid_positions(base_map);
@@ -152,10 +152,10 @@ void solver<DAY, 1>::solve(const char* input, char* output)
     }
     point_id++;
   }
-  sprintf(output, "%d, (%d, %d)", best_visible_asteroids, p.x, p.y);
+  output.print("%d, (%d, %d)", best_visible_asteroids, p.x, p.y);
 }
 
-void solver<DAY, 2>::solve(const char* input, char* output)
+void solver<DAY, 2>::solve(const char* input, output_sink& output)
 {
   vec2 center{ 23, 20 };
   map base_map = read_map(input);
@@ -238,5 +238,5 @@ void solver<DAY, 2>::solve(const char* input, char* output)
     dir_id = (dir_id + 1) % angle_groups.size();
   }
 
-  sprintf(output, "%d %d", p.x, p.y);
+  output.print("%d %d", p.x, p.y);
 }
@@ -1,84 +1,189 @@
 #include <algorithm>
 #include <cassert>
+#include <thread>
 #include <vector>
 
 #include "solver.hpp"
+#include "common/cycle_detection.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NBODY_SSE2 1
+#include <emmintrin.h>
+#else
+#define NBODY_SSE2 0
+#endif
 
 constexpr int DAY = 12;
 namespace
 {
 
-struct planet_system
+// Gravity only pulls along each axis by the sign of the difference, so the axes never interact:
+// a system of bodies is three independent one-dimensional systems.
+// Positions and velocities of all bodies on one axis, structure of arrays, padded to whole
+// vectors of 'lanes' bodies with bodies that stay at 0.
+class axis_system
 {
-  int p[4][3];
-  int v[4][3];
-};
+public:
+  static const int lanes = 4;
 
-static inline bool operator==(planet_system const& l, planet_system const&r)
-{
-  for (int i = 0; i < 4; i++)
+  axis_system() = default;
+
+  explicit axis_system(std::vector<int32_t> const& positions)
+    : num_bodies{ (int)positions.size() },
+      p((positions.size() + lanes - 1) / lanes * lanes, 0),
+      v(p.size(), 0)
   {
-    for (int d = 0; d < 3; d++)
+    std::copy(positions.begin(), positions.end(), p.begin());
+  }
+
+  int size() const
+  {
+    return num_bodies;
+  }
+
+  int32_t position(int i) const
+  {
+    return p[i];
+  }
+
+  int32_t velocity(int i) const
+  {
+    return v[i];
+  }
+
+  // Applies gravity between every pair of bodies, then velocity.
+  void step()
+  {
+    apply_gravity();
+    for (size_t i = 0; i < p.size(); i++)
     {
-      if (l.p[i][d] != r.p[i][d]) return false;
-      if (l.v[i][d] != r.v[i][d]) return false;
+      p[i] += v[i];
     }
   }
-  return true;
-}
 
-static inline bool operator!=(planet_system const& l, planet_system const& r)
-{
-  return !(l == r);
-}
+  bool at_rest() const
+  {
+    return std::all_of(v.begin(), v.end(), [](int32_t velocity) { return velocity == 0; });
+  }
 
-static int sign(int x)
-{
-  return x == 0 ? 0 : (x > 0 ? 1 : -1);
-}
+  bool operator==(axis_system const& other) const
+  {
+    // Padding is always 0.
+    return p == other.p && v == other.v;
+  }
 
-planet_system simulate_step(planet_system const& s)
-{
-  planet_system ret = s;
-  for (int i = 0; i < 4; i++)
+private:
+  // v[i] += sign(p[j] - p[i]) for all j, for 'lanes' bodies i at a time.
+  void apply_gravity()
   {
-    for (int j = i + 1; j < 4; j++)
+    for (int i = 0; i < (int)p.size(); i += lanes)
     {
-      for (int d = 0; d < 3; d++)
+      // Padding bodies must not move.
+      const int real_lanes = std::min(lanes, num_bodies - i);
+#if NBODY_SSE2
+      const __m128i p_i = _mm_loadu_si128((const __m128i*)&p[i]);
+      __m128i pull = _mm_setzero_si128();
+      for (int j = 0; j < num_bodies; j++)
       {
-        int change = sign(ret.p[j][d] - ret.p[i][d]);
-        ret.v[i][d] += change;
-        ret.v[j][d] -= change;
+        const __m128i p_j = _mm_set1_epi32(p[j]);
+        // Comparisons give -1 for true, so this adds (p_j > p_i) - (p_j < p_i).
+        pull = _mm_sub_epi32(pull, _mm_cmpgt_epi32(p_j, p_i));
+        pull = _mm_add_epi32(pull, _mm_cmpgt_epi32(p_i, p_j));
       }
+      const __m128i real = _mm_cmpgt_epi32(_mm_set1_epi32(real_lanes), _mm_setr_epi32(0, 1, 2, 3));
+      __m128i* v_i = (__m128i*)&v[i];
+      _mm_storeu_si128(v_i, _mm_add_epi32(_mm_loadu_si128(v_i), _mm_and_si128(pull, real)));
+#else
+      for (int k = 0; k < real_lanes; k++)
+      {
+        int32_t pull = 0;
+        for (int j = 0; j < num_bodies; j++)
+        {
+          pull += (p[j] > p[i + k]) - (p[j] < p[i + k]);
+        }
+        v[i + k] += pull;
+      }
+#endif
     }
   }
-  for (int i = 0; i < 4; i++)
+
+  int num_bodies = 0;
+  std::vector<int32_t> p;
+  std::vector<int32_t> v;
+};
+
+const int axis_system::lanes;
+
+// Steps until the axis comes back to its initial state.
+// A step can be undone by mirroring it: with R(p, v) = (p - v, -v), the step before
+// (p, v) is R(step(R(p, v))). States at rest are their own mirror image, so if the axis is
+// at rest at step 0 and next at step t, the steps after t mirror those before it, and the
+// axis is back at step 2t, or already at step t. Only half of the period is simulated.
+uint64_t find_axis_period(axis_system const& initial)
+{
+  if (!initial.at_rest())
   {
-    for (int d = 0; d < 3; d++)
-    {
-      ret.p[i][d] += ret.v[i][d];
-    }
+    return find_period_in_place(initial, [](axis_system& axis) { axis.step(); });
   }
-  return ret;
+  axis_system axis = initial;
+  uint64_t t = 0;
+  do
+  {
+    axis.step();
+    t++;
+  } while (!axis.at_rest());
+  return axis == initial ? t : 2 * t;
 }
 
+struct planet_system
+{
+  axis_system axes[3];
+};
+
 int64_t calc_energy(planet_system const& s)
 {
   int64_t energy = 0;
-  for (int i = 0; i < 4; i++)
+  for (int i = 0; i < s.axes[0].size(); i++)
   {
     int64_t pot = 0;
     int64_t kin = 0;
     for (int d = 0; d < 3; d++)
     {
-      pot += std::abs(s.p[i][d]);
-      kin += std::abs(s.v[i][d]);
+      pot += std::abs(s.axes[d].position(i));
+      kin += std::abs(s.axes[d].velocity(i));
     }
     energy += pot * kin;
   }
   return energy;
 }
 
+// One body per line, "<x=.., y=.., z=..>", any number of them.
+planet_system read_planet_system(const char* input)
+{
+  std::vector<int32_t> positions[3];
+  int x, y, z;
+  while (sscanf(input, " <x=%d, y=%d, z=%d>", &x, &y, &z) == 3)
+  {
+    positions[0].push_back(x);
+    positions[1].push_back(y);
+    positions[2].push_back(z);
+    while (*input != '\n' && *input != 0)
+    {
+      input++;
+    }
+    if (*input == '\n')
+    {
+      input++;
+    }
+  }
+  planet_system s;
+  for (int d = 0; d < 3; d++)
+  {
+    s.axes[d] = axis_system(positions[d]);
+  }
+  return s;
+}
+
 static int64_t gcd(int64_t a, int64_t b)
 {
   if (a == 0) return b;
@@ -92,59 +197,32 @@ static int64_t lcm(int64_t a, int64_t b)
 }
 
 }
-void solver<DAY, 1>::solve(const char* input, char* output)
+void solver<DAY, 1>::solve(const char* input, output_sink& output)
 {
-  planet_system s;
-  for (int i = 0; i < 4; i++)
-  {
-    sscanf(input, "<x=%d, y=%d, z=%d>", &s.p[i][0], &s.p[i][1], &s.p[i][2]);
-    s.v[i][0] = 0;
-    s.v[i][1] = 0;
-    s.v[i][2] = 0;
-    while (*input != '\n' && *input != 0)
-    {
-      input++;
-    }
-    if (*input == '\n')
-    {
-      input++;
-    }
-  }
-  planet_system initial_s;
-  initial_s = s;
+  const planet_system initial_s = read_planet_system(input);
 
+  // Each step has a unique predecessor, so every axis comes back to its initial state
+  // after its own period, and the whole system after their lcm.
+  // The axes are independent, so each gets a thread.
   int64_t num_steps[3] = { 0, 0, 0 };
-  bool period_found[3] = { false, false, false };
-  do
+  std::thread axis_threads[2];
+  for (int d = 1; d < 3; d++)
   {
-    s = simulate_step(s);
-    for (int d = 0; d < 3; d++)
-    {
-      if (!period_found[d]) num_steps[d]++;
-    }
-    for (int d = 0; d < 3; d++)
+    axis_threads[d - 1] = std::thread([&initial_s, &num_steps, d]()
     {
-      if (period_found[d]) continue;
-      period_found[d] = true;
-      for (int i = 0; i < 4; i++)
-      {
-        if (!(s.p[i][d] == initial_s.p[i][d] && s.v[i][d] == initial_s.v[i][d]))
-        {
-          period_found[d] = false;
-          break;
-        }
-      }
-      if (period_found[d])
-      {
-        printf("period %d\n", d);
-      }
-    }
-  } while (!(period_found[0] && period_found[1] && period_found[2]));
+      num_steps[d] = (int64_t)find_axis_period(initial_s.axes[d]);
+    });
+  }
+  num_steps[0] = (int64_t)find_axis_period(initial_s.axes[0]);
+  for (std::thread& t : axis_threads)
+  {
+    t.join();
+  }
 
-  sprintf(output, "%lld", lcm(lcm(num_steps[0], num_steps[1]), num_steps[2]));
+  output.print("%lld", lcm(lcm(num_steps[0], num_steps[1]), num_steps[2]));
 }
 
-void solver<DAY, 2>::solve(const char* input, char* output)
+void solver<DAY, 2>::solve(const char* input, output_sink& output)
 {
   (void)input;
   (void)output;
@@ -8,9 +8,9 @@
 
 constexpr int DAY = 13;
 
-void solver<DAY, 1>::solve(const char* input, char* output)
+void solver<DAY, 1>::solve(const char* input, output_sink& output)
 {
-  intcode_program program = read_intcode_program(input);
+  intcode_program program = load_intcode_program(input);
   intcode_machine machine(program);
   machine.run();
   assert(machine.get_state() == intcode_machine::execution_state::halted);
@@ -38,12 +38,12 @@ void solver<DAY, 1>::solve(const char* input, char* output)
       ball_x = x;
     }
   }
-  sprintf(output, "%lld", num_blocks);
+  output.print("%lld", num_blocks);
 }
 
-void solver<DAY, 2>::solve(const char* input, char* output)
+void solver<DAY, 2>::solve(const char* input, output_sink& output)
 {
-  intcode_program program = read_intcode_program(input);
+  intcode_program program = load_intcode_program(input);
 
   int64_t num_blocks = 0;
   int64_t ball_x = 0;
@@ -126,5 +126,5 @@ void solver<DAY, 2>::solve(const char* input, char* output)
     }
   } while (num_blocks > 0);
 
-  sprintf(output, "%lld", score);
+  output.print("%lld", score);
 }
@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 
+#include "parse_cache.hpp"
 #include "solver.hpp"
 
 constexpr int DAY = 14;
@@ -83,6 +84,58 @@ std::unordered_map<std::string, reaction> read_reactions(const char* input)
   return reactions;
 }
 
+using reaction_map = std::unordered_map<std::string, reaction>;
+
+void save_chemical_batch(parse_cache_writer& writer, chemical_batch const& batch)
+{
+  writer.write(batch.quantity);
+  writer.write_string(batch.name);
+}
+
+chemical_batch restore_chemical_batch(parse_cache_reader& reader)
+{
+  chemical_batch batch;
+  batch.quantity = reader.read<int64_t>();
+  batch.name = reader.read_string();
+  return batch;
+}
+
+// read_reactions() through the parse cache.
+reaction_map load_reactions(const char* input)
+{
+  return cached_parse("day14-reactions", input, read_reactions,
+    [](parse_cache_writer& writer, reaction_map const& reactions)
+    {
+      writer.write<uint64_t>(reactions.size());
+      for (auto const& entry : reactions)
+      {
+        save_chemical_batch(writer, entry.second.output);
+        writer.write<uint64_t>(entry.second.input.size());
+        for (chemical_batch const& batch : entry.second.input)
+        {
+          save_chemical_batch(writer, batch);
+        }
+      }
+    },
+    [](parse_cache_reader& reader)
+    {
+      reaction_map reactions;
+      const uint64_t num_reactions = reader.read<uint64_t>();
+      for (uint64_t i = 0; i < num_reactions && reader.good(); i++)
+      {
+        reaction reac;
+        reac.output = restore_chemical_batch(reader);
+        const uint64_t num_inputs = reader.read<uint64_t>();
+        for (uint64_t j = 0; j < num_inputs && reader.good(); j++)
+        {
+          reac.input.push_back(restore_chemical_batch(reader));
+        }
+        reactions.emplace(reac.output.name, reac);
+      }
+      return reactions;
+    });
+}
+
 int64_t find_chemical_order(std::unordered_map<std::string, reaction> const& reactions,
                             std::unordered_map<std::string, int64_t>& orders,
                             std::string const& name)
@@ -144,9 +197,15 @@ int64_t find_ore_quantity(std::unordered_map<std::string, reaction> const& react
 }
 
 }
-void solver<DAY, 1>::solve(const char* input, char* output)
+template <>
+void parse_input<DAY>(const char* input)
+{
+  read_reactions(input);
+}
+
+void solver<DAY, 1>::solve(const char* input, output_sink& output)
 {
-  auto reactions = read_reactions(input);
+  auto reactions = load_reactions(input);
   std::unordered_map<std::string, int64_t> orders;
   orders.emplace("ORE", 0);
   for (auto const& reac : reactions)
@@ -154,12 +213,12 @@ void solver<DAY, 1>::solve(const char* input, char* output)
     find_chemical_order(reactions, orders, reac.first);
   }
 
-  sprintf(output, "%lld", find_ore_quantity(reactions, orders, 1));
+  output.print("%lld", find_ore_quantity(reactions, orders, 1));
 }
 
-void solver<DAY, 2>::solve(const char* input, char* output)
+void solver<DAY, 2>::solve(const char* input, output_sink& output)
 {
-  auto reactions = read_reactions(input);
+  auto reactions = load_reactions(input);
   std::unordered_map<std::string, int64_t> orders;
   orders.emplace("ORE", 0);
   for (auto const& reac : reactions)
@@ -184,5 +243,5 @@ void solver<DAY, 2>::solve(const char* input, char* output)
     }
   }
 
-  sprintf(output, "%lld", l);
+  output.print("%lld", l);
 }
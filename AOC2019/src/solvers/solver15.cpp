@@ -1,13 +1,12 @@
 #include <algorithm>
 #include <cassert>
 #include <queue>
-#include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 #include "common/intcode_machine.hpp"
 #include "solver.hpp"
 #include "common/a_star.hpp"
+#include "common/chunked_grid.hpp"
 #include "common/vec2.hpp"
 
 constexpr int DAY = 15;
@@ -23,11 +22,12 @@ enum dir : int
   east = 4
 };
 
-using map_type = std::unordered_map<vec2, int, vec2_hasher>;
+// -1 unexplored, 0 wall, 1 free, 2 oxygen.
+using map_type = chunked_grid<int>;
 
 std::vector<dir> find_path_with_templated_a_star(map_type const& map, vec2 start, vec2 finish)
 {
-  auto list_adjacent = [&map, finish](vec2 p) -> std::vector<vec2>
+  auto list_adjacent = [&map, finish](vec2 p, grid_neighbours& out)
   {
     vec2 neighbours[] = {
       vec2{p.x + 1, p.y},
@@ -36,20 +36,14 @@ std::vector<dir> find_path_with_templated_a_star(map_type const& map, vec2 start
       vec2{p.x, p.y + 1}
     };
 
-    std::vector<vec2> ret;
     for (vec2 const& next : neighbours)
     {
-      if (map.find(next) != map.end())
+      int const* map_value = map.find(next);
+      if (map_value != nullptr && (*map_value == 1 || *map_value == 2 || (*map_value == -1 && next == finish)))
       {
-        int map_value = map.at(next);
-        if (map_value == 1 || map_value == 2 || (map_value == -1 && next == finish))
-        {
-          ret.push_back(next);
-        }
+        out.push_back(next);
       }
     }
-
-    return ret;
   };
 
   auto transition_cost = [&map](vec2, vec2) -> int64_t
@@ -62,7 +56,17 @@ std::vector<dir> find_path_with_templated_a_star(map_type const& map, vec2 start
     return std::abs(finish.x - start.x) + std::abs(finish.y - start.y);
   };
 
-  std::vector<vec2> path = a_star<vec2, vec2_hasher, int64_t, decltype(list_adjacent), decltype(transition_cost), decltype(heuristic)>(start, finish, list_adjacent, transition_cost, heuristic);
+  // Not on the map, so unreachable.
+  if (!map.contains(finish))
+  {
+    return {};
+  }
+  // Every neighbour is a known cell, so the known part of the map bounds the search.
+  const vec2 min_known = map.min_cell();
+  const vec2 max_known = map.max_cell();
+  assert(map.contains(start));
+  const grid_bounds bounds{ min_known, max_known.x - min_known.x + 1, max_known.y - min_known.y + 1 };
+  std::vector<vec2> path = a_star<int64_t, bucket_frontier<vec2, int64_t>>(bounds, start, finish, list_adjacent, transition_cost, heuristic);
 
   vec2 cur_p = path.back();
   path.pop_back();
@@ -95,9 +99,9 @@ std::vector<dir> find_path_with_templated_a_star(map_type const& map, vec2 start
 
 } // namespace
 
-void solver<DAY, 1>::solve(const char* input, char* output)
+void solver<DAY, 1>::solve(const char* input, output_sink& output)
 {
-  intcode_program program = read_intcode_program(input);
+  intcode_program program = load_intcode_program(input);
   intcode_machine machine(program);
   vec2 droid_pos = { 0, 0 };
 
@@ -154,7 +158,7 @@ void solver<DAY, 1>::solve(const char* input, char* output)
           case dir::west: new_unknown.x--; break;
           case dir::east: new_unknown.x++; break;
         }
-        if (map.find(new_unknown) == map.end())
+        if (!map.contains(new_unknown))
         {
           map[new_unknown] = -1;
           unknown.push_back(new_unknown);
@@ -163,21 +167,14 @@ void solver<DAY, 1>::solve(const char* input, char* output)
     }
   }
 
-  vec2 min_map = { INT_MAX, INT_MAX };
-  vec2 max_map = { INT_MIN, INT_MIN };
-  for (auto const& p : map)
-  {
-    min_map.x = std::min(min_map.x, p.first.x);
-    min_map.y = std::min(min_map.y, p.first.y);
-    max_map.x = std::max(max_map.x, p.first.x);
-    max_map.y = std::max(max_map.y, p.first.y);
-  }
+  const vec2 min_map = map.min_cell();
+  const vec2 max_map = map.max_cell();
 
   for (int y = max_map.y; y >= min_map.y; y--)
   {
     for (int x = min_map.x; x <= max_map.x; x++)
     {
-      if (map.find({ x, y }) != map.end())
+      if (map.contains({ x, y }))
       {
         if (vec2{ x, y } == droid_pos)
         {
@@ -209,15 +206,14 @@ void solver<DAY, 1>::solve(const char* input, char* output)
   printf("Droid pos: (%d, %d)\n", droid_pos.x, droid_pos.y);
   printf("\n");
 
-  sprintf(output, "%llu", find_path_with_templated_a_star(map, { 0, 0 }, global_target).size());
-  output += strlen(output);
+  output.print("%llu", find_path_with_templated_a_star(map, { 0, 0 }, global_target).size());
 
   // Flow from oxygen tank
   auto map_has_free_place = [](map_type const& map) -> bool
   {
-    return std::any_of(map.begin(), map.end(), [](std::pair<vec2, int> const& p)
+    return map.any_of([](vec2, int value)
     {
-      return p.second == 1;
+      return value == 1;
     });
   };
 
@@ -226,13 +222,13 @@ void solver<DAY, 1>::solve(const char* input, char* output)
   {
     fill_iter++;
     map_type tmp_map = map;
-    for (auto p : map)
+    map.for_each([&map, &tmp_map](vec2 p, int value)
     {
-      if (p.second == 2)
+      if (value == 2)
       {
         for (int i = 1; i <= 4; i++)
         {
-          vec2 next = p.first;
+          vec2 next = p;
           switch ((dir)i)
           {
             case dir::north: next.y++; break;
@@ -242,17 +238,17 @@ void solver<DAY, 1>::solve(const char* input, char* output)
           }
           if (map.at(next) == 1)
           {
-            tmp_map[next] = 2;
+            tmp_map.at(next) = 2;
           }
         }
       }
-    }
+    });
     map = tmp_map;
   }
-  sprintf(output, "\n%d", fill_iter);
+  output.print("\n%d", fill_iter);
 }
 
-void solver<DAY, 2>::solve(const char* input, char* output)
+void solver<DAY, 2>::solve(const char* input, output_sink& output)
 {
   (void)input;
   (void)output;
@@ -38,7 +38,7 @@ void fft_2_latter_half(std::vector<uint8_t> const& src, std::vector<uint8_t>& ds
 }
 
 }
-void solver<DAY, 1>::solve(const char* input, char* output)
+void solver<DAY, 1>::solve(const char* input, output_sink& output)
 {
   std::vector<int64_t> numbers;
   while (*input)
@@ -54,12 +54,11 @@ void solver<DAY, 1>::solve(const char* input, char* output)
 
   for (int i = 0; i < 8; i++)
   {
-    sprintf(output, "%lld ", numbers[i]);
-    output += strlen(output);
+    output.print("%lld ", numbers[i]);
   }
 }
 
-void solver<DAY, 2>::solve(const char* input, char* output)
+void solver<DAY, 2>::solve(const char* input, output_sink& output)
 {
   std::vector<uint8_t> numbers;
   while (*input)
@@ -94,7 +93,6 @@ void solver<DAY, 2>::solve(const char* input, char* output)
 
   for (int i = 0; i < 8; i++)
   {
-    sprintf(output, "%d", (int)(buffers[cur][i + message_offset]));
-    output += strlen(output);
+    output.print("%d", (int)(buffers[cur][i + message_offset]));
   }
 }
@@ -8,9 +8,9 @@
 
 constexpr int DAY = 17;
 
-void solver<DAY, 1>::solve(const char* input, char* output)
+void solver<DAY, 1>::solve(const char* input, output_sink& output)
 {
-  intcode_machine machine(read_intcode_program(input));
+  intcode_machine machine(load_intcode_program(input));
   machine.run();
   std::vector<char> map;
   while (true)
@@ -35,7 +35,7 @@ void solver<DAY, 1>::solve(const char* input, char* output)
     map_width++;
   }
   map_height = (int)(map.size() - 1) / (map_width + 1);
-  output += sprintf(output, "%s", map.data());
+  output.print("%s", map.data());
 
   auto map_at = [&map, map_height, map_width](int x, int y) -> char
   {
@@ -58,16 +58,16 @@ void solver<DAY, 1>::solve(const char* input, char* output)
       }
     }
   }
-  output += sprintf(output, "\n%d\n", sum);
+  output.print("\n%d\n", sum);
 }
 
-void solver<DAY, 2>::solve(const char* input, char* output)
+void solver<DAY, 2>::solve(const char* input, output_sink& output)
 {
   std::vector<char> map;
   int map_width = 0;
   int map_height = 0;
 
-  intcode_program program = read_intcode_program(input);
+  intcode_program program = load_intcode_program(input);
   {
     intcode_machine machine(program);
     machine.run();
@@ -91,7 +91,7 @@ void solver<DAY, 2>::solve(const char* input, char* output)
       map_width++;
     }
     map_height = (int)(map.size() - 1) / (map_width + 1);
-    output += sprintf(output, "%s", map.data());
+    output.print("%s", map.data());
   }
 
   auto map_at = [&map, &map_height, &map_width](int x, int y) -> char
@@ -201,14 +201,14 @@ pos_found:
   {
     if (c == 'R' || c == 'L')
     {
-      output += sprintf(output, "%c,", (char)c);
+      output.print("%c,", (char)c);
     }
     else
     {
-      output += sprintf(output, "%lld,", c);
+      output.print("%lld,", c);
     }
   }
-  output += sprintf(output, "\n");
+  output.print("\n");
 
   char bot_input[] = "A,B,B,C,C,A,B,B,C,A\n"
     "R,4,R,12,R,10,L,12\n"
@@ -241,5 +241,5 @@ pos_found:
   // Wrong, need to fetch last value from output
   auto out = machine.pop_output();
   assert(out.first);
-  output += sprintf(output, "Dust: %lld\n", out.second);
+  output.print("Dust: %lld\n", out.second);
 }
@@ -1,10 +1,13 @@
 #include <algorithm>
 #include <cassert>
+#include <queue>
 #include <vector>
 #include <string>
 #include <unordered_set>
 
+#include "parse_cache.hpp"
 #include "solver.hpp"
+#include "common/hash.hpp"
 #include "common/vec2.hpp"
 #include "common/a_star.hpp"
 
@@ -71,6 +74,28 @@ static map_type read_map(const char* s)
   return ret;
 }
 
+// read_map() through the parse cache.
+static map_type load_map(const char* s)
+{
+  return cached_parse("day18-map", s, read_map,
+    [](parse_cache_writer& writer, map_type const& map)
+    {
+      writer.write(map.width);
+      writer.write(map.height);
+      writer.write_array(map.data.data(), map.data.size());
+    },
+    [](parse_cache_reader& reader)
+    {
+      map_type map;
+      map.width = reader.read<int>();
+      map.height = reader.read<int>();
+      size_t size = 0;
+      const char* data = reader.read_array<char>(size);
+      map.data.assign(data, data + size);
+      return map;
+    });
+}
+
 void eliminate_dead_ends(map_type& map)
 {
   bool dead_end_found = false;
@@ -157,9 +182,13 @@ void mark_intersections(map_type& map)
   }
 }
 
-auto find_path_a_star(map_type const& map, vec2 from, vec2 to)
+// Steps all cost 1, so a bucket queue orders the frontier.
+using search_workspace = a_star_grid_workspace<int64_t, bucket_frontier<vec2, int64_t>>;
+
+// Shortest path from 'to' back to 'from', stored in 'workspace' until its next search.
+std::vector<vec2> const& find_path_a_star(search_workspace& workspace, map_type const& map, vec2 from, vec2 to)
 {
-  auto list_adjacent = [&map](vec2 p) -> std::vector<vec2>
+  auto list_adjacent = [&map](vec2 p, grid_neighbours& out)
   {
     vec2 neighbours[] = {
       vec2{p.x + 1, p.y},
@@ -168,16 +197,13 @@ auto find_path_a_star(map_type const& map, vec2 from, vec2 to)
       vec2{p.x, p.y + 1}
     };
 
-    std::vector<vec2> ret;
     for (vec2 const& next : neighbours)
     {
       if (map.at(next) != '#')
       {
-        ret.push_back(next);
+        out.push_back(next);
       }
     }
-
-    return ret;
   };
 
   auto transition_cost = [&map](vec2, vec2) -> int64_t
@@ -192,7 +218,8 @@ auto find_path_a_star(map_type const& map, vec2 from, vec2 to)
     return dx + dy;
   };
 
-  return a_star<vec2, vec2_hasher, int64_t, decltype(list_adjacent), decltype(transition_cost), decltype(heuristic)>(from, to, list_adjacent, transition_cost, heuristic);
+  const grid_bounds bounds{ { 0, 0 }, map.width, map.height };
+  return a_star(workspace, bounds, from, to, list_adjacent, transition_cost, heuristic);
 }
 
 auto find_path(map_type const& map, vec2 from, vec2 to)
@@ -285,18 +312,19 @@ uint64_t solve_1(map_type const& map, char* out_str)
     }
   }
 
+  search_workspace workspace;
   uint64_t key_to_key_dist[26][26];
   uint64_t start_to_key_dist[26];
   uint32_t req_keys[26][26];
   for (int src = 0; src < 26; src++)
   {
-    start_to_key_dist[src] = find_path_a_star(map, key_pos[src], start_pos).size() - 1;
+    start_to_key_dist[src] = find_path_a_star(workspace, map, key_pos[src], start_pos).size() - 1;
     for (int dst = src; dst < 26; dst++)
     {
-      key_to_key_dist[src][dst] = find_path_a_star(map, key_pos[src], key_pos[dst]).size() - 1;
+      key_to_key_dist[src][dst] = find_path_a_star(workspace, map, key_pos[src], key_pos[dst]).size() - 1;
       {
         auto path = find_path(map, key_pos[src], key_pos[dst]);
-        auto a_star_path = find_path_a_star(map, key_pos[src], key_pos[dst]);
+        auto const& a_star_path = find_path_a_star(workspace, map, key_pos[src], key_pos[dst]);
         if (a_star_path.size() != path.size())
         {
           fprintf(stderr, "a_star failed at (%d, %d)->(%d, %d), cost %llu, actual %llu\n",
@@ -323,7 +351,7 @@ uint64_t solve_1(map_type const& map, char* out_str)
       req_keys[src][dst] = 0;
       if (src != dst)
       {
-        auto path = find_path_a_star(map, key_pos[src], key_pos[dst]);
+        auto const& path = find_path_a_star(workspace, map, key_pos[src], key_pos[dst]);
         for (auto p : path)
         {
           char c = map.at(p);
@@ -377,7 +405,7 @@ uint64_t solve_1(map_type const& map, char* out_str)
   {
     uint64_t operator()(state const& s) const
     {
-      return s.key_found_mask;
+      return hash_mix(hash_pack(s.at_key, (int32_t)s.key_found_mask));
     }
   };
 
@@ -432,9 +460,15 @@ uint64_t solve_1(map_type const& map, char* out_str)
   return best_steps;
 }
 
-void solver<DAY, 1>::solve(const char* input, char* output)
+template <>
+void parse_input<DAY>(const char* input)
+{
+  read_map(input);
+}
+
+void solver<DAY, 1>::solve(const char* input, output_sink& output)
 {
-  map_type map = read_map(input);
+  map_type map = load_map(input);
 
   vec2 key_pos[26];
   vec2 start_pos = {};
@@ -468,25 +502,25 @@ void solver<DAY, 1>::solve(const char* input, char* output)
     }
     mark_intersections(map);
     map.data.push_back(0);
-    output += sprintf(output, "%s\n\n", map.data.data());
+    output.print("%s\n\n", map.data.data());
   }
 
   char best_str[64];
   uint64_t best_len = solve_1(map, best_str);
-  output += sprintf(output, "%s: %llu\n", best_str, best_len);
+  output.print("%s: %llu\n", best_str, best_len);
 
   vec2 from = start_pos;
   vec2 to = key_pos[best_str[0] - 'a'];
-  output += sprintf(output, "@ -> %c: ", best_str[0]);
+  output.print("@ -> %c: ", best_str[0]);
   for (int i = 0; i < strlen(best_str); i++)
   {
     auto path = find_path(map, from, to);
-    output += sprintf(output, "%llu\n", path.size() - 1);
+    output.print("%llu\n", path.size() - 1);
     if (i == strlen(best_str) - 1)
     {
       break;
     }
-    output += sprintf(output, "%c -> %c: ", best_str[i], best_str[i + 1]);
+    output.print("%c -> %c: ", best_str[i], best_str[i + 1]);
     from = to;
     to = key_pos[best_str[i + 1] - 'a'];
   }
@@ -514,6 +548,7 @@ uint64_t solve_2(map_type const& map)
   start_pos[2] = { 41, 41 };
   start_pos[3] = { 41, 39 };
 
+  search_workspace workspace;
   uint64_t key_to_key_dist[26][26];
   uint32_t req_keys_start_to_key[4][26];
   uint64_t start_to_key_dist[4][26];
@@ -522,7 +557,7 @@ uint64_t solve_2(map_type const& map)
   {
     for (int i = 0; i < 4; i++)
     {
-      auto path = find_path_a_star(map, start_pos[i], key_pos[src]);
+      auto const& path = find_path_a_star(workspace, map, start_pos[i], key_pos[src]);
       start_to_key_dist[i][src] = path.size() - 1;
       for (auto p : path)
       {
@@ -535,12 +570,12 @@ uint64_t solve_2(map_type const& map)
     }
     for (int dst = src; dst < 26; dst++)
     {
-      key_to_key_dist[src][dst] = find_path_a_star(map, key_pos[src], key_pos[dst]).size() - 1;
+      key_to_key_dist[src][dst] = find_path_a_star(workspace, map, key_pos[src], key_pos[dst]).size() - 1;
       key_to_key_dist[dst][src] = key_to_key_dist[src][dst];
       req_keys_key_to_key[src][dst] = 0;
       if (src != dst)
       {
-        auto path = find_path_a_star(map, key_pos[src], key_pos[dst]);
+        auto const& path = find_path_a_star(workspace, map, key_pos[src], key_pos[dst]);
         for (auto p : path)
         {
           char c = map.at(p);
@@ -597,7 +632,13 @@ uint64_t solve_2(map_type const& map)
   {
     uint64_t operator()(state const& s) const
     {
-      return s.key_found_mask;
+      // Keys are -1..25, a byte per robot.
+      uint32_t positions = 0;
+      for (int i = 0; i < 4; i++)
+      {
+        positions = (positions << 8) | (uint8_t)(s.at_key[i] + 1);
+      }
+      return hash_mix(hash_pack((int32_t)positions, (int32_t)s.key_found_mask));
     }
   };
 
@@ -653,9 +694,9 @@ uint64_t solve_2(map_type const& map)
   return best_steps;
 }
 
-void solver<DAY, 2>::solve(const char* input, char* output)
+void solver<DAY, 2>::solve(const char* input, output_sink& output)
 {
-  map_type map = read_map(input);
+  map_type map = load_map(input);
   map.at({ 39, 39 }) = '@';
   map.at({ 39, 40 }) = '#';
   map.at({ 39, 41 }) = '@';
@@ -677,8 +718,8 @@ void solver<DAY, 2>::solve(const char* input, char* output)
     }
     mark_intersections(map);
     map.data.push_back(0);
-    output += sprintf(output, "%s\n\n", map.data.data());
+    output.print("%s\n\n", map.data.data());
   }
 
-  output += sprintf(output, "%llu\n", solve_2(map));
+  output.print("%llu\n", solve_2(map));
 }
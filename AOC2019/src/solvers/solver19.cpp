@@ -4,51 +4,66 @@
 
 #include "solver.hpp"
 #include "common/vec2.hpp"
-#include "common/intcode_machine.hpp"
+#include "common/intcode_batch.hpp"
 
 constexpr int DAY = 19;
 
-void solver<DAY, 1>::solve(const char* input, char* output)
+// Deploys one drone per lane, at consecutive points of a row starting at 'first'.
+static void probe_row(intcode_batch& drones, vec2 first)
 {
-  intcode_program program = read_intcode_program(input);
+  drones.reset();
+  for (size_t lane = 0; lane < drones.num_lanes(); lane++)
+  {
+    drones.push_input(lane, first.x + (int)lane);
+    drones.push_input(lane, first.y);
+  }
+  drones.run();
+}
+
+void solver<DAY, 1>::solve(const char* input, output_sink& output)
+{
+  intcode_batch drones(load_intcode_program(input), 50);
   int64_t num_points = 0;
   for (int y = 0; y < 50; y++)
   {
+    probe_row(drones, { 0, y });
     for (int x = 0; x < 50; x++)
     {
-      intcode_machine machine(program);
-      machine.push_input(x);
-      machine.push_input(y);
-      machine.run();
-      num_points += machine.pop_output().second;
+      num_points += drones.pop_output(x).second;
     }
   }
-  output += sprintf(output, "%lld\n", num_points);
+  output.print("%lld\n", num_points);
 }
 
-void solver<DAY, 2>::solve(const char* input, char* output)
+void solver<DAY, 2>::solve(const char* input, output_sink& output)
 {
-  intcode_program program = read_intcode_program(input);
+  intcode_program program = load_intcode_program(input);
+  intcode_batch drones(program, 100);
   for (int y = 0; y < 100; y++)
   {
+    probe_row(drones, { 0, y });
     for (int x = 0; x < 100; x++)
     {
-      intcode_machine machine(program);
-      machine.push_input(x);
-      machine.push_input(y);
-      machine.run();
-      output += sprintf(output, "%c", machine.pop_output().second ? '#' : '.');
+      output.print("%c", drones.pop_output(x).second ? '#' : '.');
     }
-    output += sprintf(output, "\n");
+    output.print("\n");
   }
 
-  auto is_attracting = [&program](vec2 p) -> bool
+  // First x starting from 'from' where the point is (or isn't) attracting, probed a window at a time.
+  intcode_batch probes(program, 32);
+  auto find_first = [&probes](vec2 from, bool attracting) -> int
   {
-    intcode_machine machine(program);
-    machine.push_input(p.x);
-    machine.push_input(p.y);
-    machine.run();
-    return machine.pop_output().second != 0;
+    for (int x = from.x; ; x += (int)probes.num_lanes())
+    {
+      probe_row(probes, { x, from.y });
+      for (size_t lane = 0; lane < probes.num_lanes(); lane++)
+      {
+        if ((probes.pop_output(lane).second != 0) == attracting)
+        {
+          return x + (int)lane;
+        }
+      }
+    }
   };
 
   std::vector<vec2> interval_for_y(2000);
@@ -56,17 +71,9 @@ void solver<DAY, 2>::solve(const char* input, char* output)
   const int start_y = 800;
   for (int y = start_y; y < interval_for_y.size(); y++)
   {
-    int l = interval_for_y[y-1].x;
-    while (is_attracting({ l, y }) == false)
-    {
-      l++;
-    }
-
-    int r = l;
-    while (is_attracting({ r, y }) == true)
-    {
-      r++;
-    }
+    int l = find_first({ interval_for_y[y-1].x, y }, true);
+    // The beam is a cone, so it covers at least up to where it ended on the previous row.
+    int r = find_first({ std::max(l, interval_for_y[y-1].y), y }, false);
     interval_for_y[y] = { l, r - 1 };
   }
 
@@ -84,10 +91,10 @@ void solver<DAY, 2>::solve(const char* input, char* output)
 
   if (target.x != INT_MAX)
   {
-  output += sprintf(output, "%d\n", 10000 * target.x + target.y);
+  output.print("%d\n", 10000 * target.x + target.y);
   }
   else
   {
-    output += sprintf(output, "failure\n");
+    output.print("failure\n");
   }
 }
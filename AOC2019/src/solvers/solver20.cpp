@@ -5,6 +5,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "parse_cache.hpp"
 #include "solver.hpp"
 #include "common/vec2.hpp"
 #include "common/a_star.hpp"
@@ -34,7 +35,7 @@ struct multilevel_point_hasher
 {
   uint64_t operator()(multilevel_point const& p) const
   {
-    return vec2_hasher{}(p.position);
+    return hash_combine(vec2_hasher{}(p.position), (uint64_t)p.level);
   }
 };
 
@@ -55,10 +56,8 @@ struct map_type
     return p.x >= 0 && p.x < width && p.y >= 0 && p.y < height;
   }
 
-  std::vector<vec2> list_walkable_neighbours(vec2 p) const
+  void list_walkable_neighbours(vec2 p, grid_neighbours& ret) const
   {
-    std::vector<vec2> ret;
-
     const vec2 neighbours[] = { {p.x + 1, p.y}, {p.x - 1, p.y}, {p.x, p.y + 1}, {p.x, p.y - 1} };
     for (auto next : neighbours)
     {
@@ -76,8 +75,6 @@ struct map_type
         }
       }
     }
-
-    return ret;
   }
 
   std::vector<multilevel_point> list_walkable_neighbours_multilevel(multilevel_point p) const
@@ -242,11 +239,57 @@ static map_type read_map(const char* s)
   return map;
 }
 
+// read_map() through the parse cache.
+// Only the grid and the portals are stored, the lookup tables are rebuilt from the portals.
+static map_type load_map(const char* s)
+{
+  return cached_parse("day20-map", s, read_map,
+    [](parse_cache_writer& writer, map_type const& map)
+    {
+      writer.write(map.width);
+      writer.write(map.height);
+      writer.write_array(map.data.data(), map.data.size());
+      writer.write<uint64_t>(map.portals.size());
+      for (auto const& portal : map.portals)
+      {
+        writer.write_string(portal.first);
+        writer.write_array(portal.second.data(), portal.second.size());
+      }
+    },
+    [](parse_cache_reader& reader)
+    {
+      map_type map;
+      map.width = reader.read<int>();
+      map.height = reader.read<int>();
+      size_t size = 0;
+      const char* data = reader.read_array<char>(size);
+      map.data.assign(data, data + size);
+      const uint64_t num_portals = reader.read<uint64_t>();
+      for (uint64_t i = 0; i < num_portals && reader.good(); i++)
+      {
+        std::string portal_name = reader.read_string();
+        size_t num_positions = 0;
+        const portal_position* positions = reader.read_array<portal_position>(num_positions);
+        for (size_t j = 0; j < num_positions; j++)
+        {
+          map.portal_at_position[positions[j].floor_position] = portal_name;
+        }
+        if (num_positions == 2)
+        {
+          map.portal_traversals[positions[0].floor_position + positions[0].entrance_offset] = positions[1].floor_position;
+          map.portal_traversals[positions[1].floor_position + positions[1].entrance_offset] = positions[0].floor_position;
+        }
+        map.portals[portal_name].assign(positions, positions + num_positions);
+      }
+      return map;
+    });
+}
+
 auto find_path(map_type const& map, vec2 start, vec2 finish)
 {
-  auto list_adjacent = [&map](vec2 p) -> std::vector<vec2>
+  auto list_adjacent = [&map](vec2 p, grid_neighbours& out)
   {
-    return map.list_walkable_neighbours(p);
+    map.list_walkable_neighbours(p, out);
   };
 
   auto transition_cost = [&map](vec2, vec2) -> int64_t
@@ -259,7 +302,8 @@ auto find_path(map_type const& map, vec2 start, vec2 finish)
     return 0;
   };
 
-  return a_star<vec2, vec2_hasher, int64_t, decltype(list_adjacent), decltype(transition_cost), decltype(heuristic)>(start, finish, list_adjacent, transition_cost, heuristic);;
+  const grid_bounds bounds{ { 0, 0 }, map.width, map.height };
+  return a_star<int64_t, bucket_frontier<vec2, int64_t>>(bounds, start, finish, list_adjacent, transition_cost, heuristic);
 }
 
 auto find_path_multilevel(map_type const& map, vec2 start, vec2 finish)
@@ -279,18 +323,26 @@ auto find_path_multilevel(map_type const& map, vec2 start, vec2 finish)
     return 0;
   };
 
-  return a_star<multilevel_point, multilevel_point_hasher, int64_t, decltype(list_adjacent), decltype(transition_cost), decltype(heuristic)>({ start, 0 }, { finish, 0 }, list_adjacent, transition_cost, heuristic);;
+  // Costs only grow along the search, which is all a radix heap needs.
+  using frontier_type = radix_heap_frontier<multilevel_point, int64_t>;
+  return a_star<multilevel_point, multilevel_point_hasher, int64_t, decltype(list_adjacent), decltype(transition_cost), decltype(heuristic), frontier_type>({ start, 0 }, { finish, 0 }, list_adjacent, transition_cost, heuristic);
 }
 
 } // namespace
 
-void solver<DAY, 1>::solve(const char* input, char* output)
+template <>
+void parse_input<DAY>(const char* input)
+{
+  read_map(input);
+}
+
+void solver<DAY, 1>::solve(const char* input, output_sink& output)
 {
-  map_type map = read_map(input);
+  map_type map = load_map(input);
   {
     map_type simplified_map = map;
     simplified_map.eliminate_dead_ends();
-    output += sprintf(output, "Map with eliminated dead ends:\n%s\n\n", simplified_map.data.data());
+    output.print("Map with eliminated dead ends:\n%s\n\n", simplified_map.data.data());
   }
   uint64_t path_length = 0;
   {
@@ -301,22 +353,22 @@ void solver<DAY, 1>::solve(const char* input, char* output)
     {
       marked_map.at(p) = '*';
     }
-    output += sprintf(output, "Map with path:\n%s\n\n", marked_map.data.data());
+    output.print("Map with path:\n%s\n\n", marked_map.data.data());
   }
-  output += sprintf(output, "Path length: %llu\n", path_length);
+  output.print("Path length: %llu\n", path_length);
 }
 
-void solver<DAY, 2>::solve(const char* input, char* output)
+void solver<DAY, 2>::solve(const char* input, output_sink& output)
 {
-  map_type map = read_map(input);
+  map_type map = load_map(input);
   map_type simplified_map = map;
   simplified_map.eliminate_dead_ends();
-  output += sprintf(output, "%s\n\n", simplified_map.data.data());
+  output.print("%s\n\n", simplified_map.data.data());
   uint64_t path_length = 0;
   {
-    output += sprintf(output, "Path:\n");
+    output.print("Path:\n");
     auto path = find_path_multilevel(simplified_map, simplified_map.portals.at("AA")[0].floor_position, simplified_map.portals.at("ZZ")[0].floor_position);
     path_length = path.size() - 1;
   }
-  output += sprintf(output, "Path length: %llu\n", path_length);
+  output.print("Path length: %llu\n", path_length);
 }
@@ -62,9 +62,9 @@ enum registers : char
 // Put solution helpers here
 } // namespace
 
-void solver<DAY, 1>::solve(const char* input, char* output)
+void solver<DAY, 1>::solve(const char* input, output_sink& output)
 {
-  auto program = read_intcode_program(input);
+  auto program = load_intcode_program(input);
   const char* drone_programs[]{
     "NOT A J\nWALK\n",
     "NOT C T\nAND D T\nAND B T\nNOT A J\nOR T J\nWALK\n",
@@ -85,7 +85,7 @@ void solver<DAY, 1>::solve(const char* input, char* output)
       s++;
     }
     machine.run();
-    output += sprintf(output, "Program:\n%s\n", drone_program);
+    output.print("Program:\n%s\n", drone_program);
     while (true)
     {
       auto out = machine.pop_output();
@@ -95,24 +95,24 @@ void solver<DAY, 1>::solve(const char* input, char* output)
       }
       if (out.second < 256)
       {
-        output += sprintf(output, "%c", (char)(out.second));
+        output.print("%c", (char)(out.second));
       }
       else
       {
-        output += sprintf(output, "%lld\n", out.second);
+        output.print("%lld\n", out.second);
       }
     }
   }
 }
 
-void solver<DAY, 2>::solve(const char* input, char* output)
+void solver<DAY, 2>::solve(const char* input, output_sink& output)
 {
   // !A | (D & ( (B & !C) | (!B & C) | (B & !C & E & !F)))
   // ##.#..###
   // ##.##.##.
   // #.##...##
 
-  intcode_machine machine{ read_intcode_program(input) };
+  intcode_machine machine{ load_intcode_program(input) };
   drone_program drone_pr;
 
   drone_pr
@@ -141,11 +141,11 @@ void solver<DAY, 2>::solve(const char* input, char* output)
     }
     if (out.second < 256)
     {
-      output += sprintf(output, "%c", (char)(out.second));
+      output.print("%c", (char)(out.second));
     }
     else
     {
-      output += sprintf(output, "%lld\n", out.second);
+      output.print("%lld\n", out.second);
     }
   }
 }
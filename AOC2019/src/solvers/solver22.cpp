@@ -95,7 +95,7 @@ constexpr int64_t mod_inv(int64_t x)
 // Put solution helpers here
 } // namespace
 
-void solver<DAY, 1>::solve(const char* input, char* output)
+void solver<DAY, 1>::solve(const char* input, output_sink& output)
 {
   std::vector<int64_t> deck(10007);
   for (uint64_t i = 0; i < deck.size(); i++)
@@ -135,13 +135,13 @@ void solver<DAY, 1>::solve(const char* input, char* output)
   {
     if (deck[i] == 2019)
     {
-      output += sprintf(output, "%llu", i);
+      output.print("%llu", i);
       break;
     }
   }
 }
 
-void solver<DAY, 2>::solve(const char* input, char* output)
+void solver<DAY, 2>::solve(const char* input, output_sink& output)
 {
   std::vector<command> commands;
   while (*input)
@@ -208,7 +208,7 @@ void solver<DAY, 2>::solve(const char* input, char* output)
 
   constexpr int64_t n = 101741582076661;
 
-  output += sprintf(output, "a=%lld, b=%lld\n", shuffle.a, shuffle.b);
+  output.print("a=%lld, b=%lld\n", shuffle.a, shuffle.b);
 
   uint64_t a = shuffle.a;
   uint64_t b = shuffle.b;
@@ -227,5 +227,5 @@ void solver<DAY, 2>::solve(const char* input, char* output)
       ),
       mod_inv(a_to_n)
     );
-  output += sprintf(output, "ret=%lld\n", ret);
+  output.print("ret=%lld\n", ret);
 }
@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <cassert>
+#include <queue>
 #include <unordered_map>
 #include <vector>
 
@@ -18,11 +19,11 @@ struct packet
 // Put solution helpers here
 } // namespace
 
-void solver<DAY, 1>::solve(const char* input, char* output)
+void solver<DAY, 1>::solve(const char* input, output_sink& output)
 {
   const unsigned int num_machines = 50;
 
-  intcode_program program = read_intcode_program(input);
+  intcode_program program = load_intcode_program(input);
   char memory[num_machines * sizeof(intcode_machine)];
   intcode_machine* machines[num_machines];
   std::queue<packet> pending_packets[num_machines];
@@ -87,7 +88,7 @@ void solver<DAY, 1>::solve(const char* input, char* output)
     }
   }
 
-  output += sprintf(output, "%lld", ret);
+  output.print("%lld", ret);
 
   for (int i = 0; i < 50; i++)
   {
@@ -95,11 +96,11 @@ void solver<DAY, 1>::solve(const char* input, char* output)
   }
 }
 
-void solver<DAY, 2>::solve(const char* input, char* output)
+void solver<DAY, 2>::solve(const char* input, output_sink& output)
 {
   const unsigned int num_machines = 50;
 
-  intcode_program program = read_intcode_program(input);
+  intcode_program program = load_intcode_program(input);
   char memory[num_machines * sizeof(intcode_machine)];
   intcode_machine* machines[num_machines];
   std::queue<packet> pending_packets[num_machines];
@@ -198,7 +199,7 @@ void solver<DAY, 2>::solve(const char* input, char* output)
     }
   }
 
-  output += sprintf(output, "%lld", ret);
+  output.print("%lld", ret);
 
   for (int i = 0; i < 50; i++)
   {
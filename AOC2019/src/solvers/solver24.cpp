@@ -2,312 +2,201 @@
 #include <cassert>
 #include <vector>
 
-#include <unordered_map>
-#include <unordered_set>
 #include "solver.hpp"
-#include "common/vec2.hpp"
+#include "common/cycle_detection.hpp"
 
 constexpr int DAY = 24;
 
 namespace
 {
-struct map
+// A 5x5 level is a bitboard, bug at (x, y) is bit x + 5 * y.
+using level = uint32_t;
+
+const int width = 5;
+const int height = 5;
+const level all_cells = (1u << (width * height)) - 1;
+
+constexpr level cell(int x, int y)
 {
-  map() : data(width * height, '.')
-  {
-  }
-  map(map const& other) : data(other.data)
-  {
-  }
-  map& operator=(map const& other)
-  {
-    if (this != &other)
-    {
-      data = other.data;
-    }
-    return *this;
-  }
+  return 1u << (x + y * width);
+}
 
-  char& at(int x, int y)
+const level column_0 = cell(0, 0) | cell(0, 1) | cell(0, 2) | cell(0, 3) | cell(0, 4);
+const level column_4 = column_0 << 4;
+const level row_0 = cell(0, 0) | cell(1, 0) | cell(2, 0) | cell(3, 0) | cell(4, 0);
+const level row_4 = row_0 << 20;
+// The tile leading one level in, and its four neighbours.
+const level center = cell(2, 2);
+const level above_center = cell(2, 1);
+const level below_center = cell(2, 3);
+const level left_of_center = cell(1, 2);
+const level right_of_center = cell(3, 2);
+
+int count_cells(level l)
+{
+  l = l - ((l >> 1) & 0x55555555u);
+  l = (l & 0x33333333u) + ((l >> 2) & 0x33333333u);
+  l = (l + (l >> 4)) & 0x0F0F0F0Fu;
+  return (int)((l * 0x01010101u) >> 24);
+}
+
+// Adds up neighbour counts of all 25 cells at once, in bit planes: a cell's count is
+// ones + 2 * twos, or four and more if its 'many' bit is set.
+struct neighbour_counter
+{
+  // Adds 1 to the count of every cell in 'cells'.
+  void add(level cells)
   {
-    return data[x + y * width];
+    const level carry = ones & cells;
+    ones ^= cells;
+    add_twos(carry);
   }
 
-  char at(int x, int y) const
+  // Adds 2 to the count of every cell in 'cells'.
+  void add_twos(level cells)
   {
-    return data[x + y * width];
+    many |= twos & cells;
+    twos ^= cells;
   }
 
-  static bool in_bounds(int x, int y)
+  // Adds 'count' to the count of every cell in 'cells'.
+  void add(level cells, int count)
   {
-    return x >= 0 && x < width && y >= 0 && y < height;
+    add((count & 1) != 0 ? cells : 0);
+    add_twos((count & 2) != 0 ? cells : 0);
+    many |= count >= 4 ? cells : 0;
   }
 
-  static bool in_bounds_2(int x, int y)
+  // Bugs survive with exactly one neighbour, and infest empty cells with one or two.
+  level next_generation(level bugs) const
   {
-    return x >= 0 && x < width && y >= 0 && y < height;
+    const level exactly_one = ones & ~twos & ~many;
+    const level exactly_two = ~ones & twos & ~many;
+    return (exactly_one | (~bugs & exactly_two)) & all_cells;
   }
 
-  static const int width = 5;
-  static const int height = 5;
-  std::vector<char> data;
+  level ones = 0;
+  level twos = 0;
+  level many = 0;
 };
 
-map process_map(map const& m)
+void add_neighbours_on_level(neighbour_counter& counter, level bugs)
 {
-  map ret = m;
-  for (int y = 0; y < m.height; y++)
-  {
-    for (int x = 0; x < m.width; x++)
-    {
-      int adjacent_bugs = 0;
-      if (map::in_bounds(x + 1, y) && m.at(x + 1, y) == '#') adjacent_bugs++;
-      if (map::in_bounds(x - 1, y) && m.at(x - 1, y) == '#') adjacent_bugs++;
-      if (map::in_bounds(x, y + 1) && m.at(x, y + 1) == '#') adjacent_bugs++;
-      if (map::in_bounds(x, y - 1) && m.at(x, y - 1) == '#') adjacent_bugs++;
-      if (m.at(x, y) == '#')
-      {
-        ret.at(x, y) = (adjacent_bugs == 1) ? '#' : '.';
-      }
-      else if (m.at(x, y) == '.')
-      {
-        ret.at(x, y) = (adjacent_bugs == 1 || adjacent_bugs == 2) ? '#' : '.';
-      }
-    }
-  }
+  counter.add((bugs << 1) & ~column_0);
+  counter.add((bugs >> 1) & ~column_4);
+  counter.add((bugs << width) & all_cells);
+  counter.add(bugs >> width);
+}
 
-  return ret;
+level process_level(level bugs)
+{
+  neighbour_counter counter;
+  add_neighbours_on_level(counter, bugs);
+  return counter.next_generation(bugs);
 }
 
-uint64_t hash_map(map const& m)
+// Levels of the recursive grid, only from the outermost to the innermost one with bugs.
+// Level 'outermost_level + i' is levels[i], level n + 1 fills the center of level n.
+struct level_hierarchy
 {
-  uint64_t ret = 0;
-  uint64_t i = 0;
-  for (int y = 0; y < m.height; y++)
+  level at(int index) const
   {
-    for (int x = 0; x < m.width; x++)
-    {
-      if (m.at(x, y) == '#')
-      {
-        ret |= (1ull << i);
-      }
-      i++;
-    }
+    return index >= 0 && index < (int)levels.size() ? levels[index] : 0;
   }
-  return ret;
-}
-
-using map_hierarchy = std::unordered_map<int, map>;
-
-static const int max_level = 299;
-static const int min_level = -299;
 
-struct tile
-{
-  int level;
-  int x;
-  int y;
+  int outermost_level = 0;
+  std::vector<level> levels;
 };
 
-std::vector<tile> adjacent_tiles(tile const& t)
+// Bugs of level 'bugs' next generation, with 'outer' the level around it and 'inner' the one in its center.
+level process_recursive_level(level bugs, level outer, level inner)
 {
-  assert(t.x != 2 || t.y != 2);
-  std::vector<tile> ret;
-
-  if (map::in_bounds(t.x + 1, t.y))
-  {
-    if (t.x + 1 == 2 && t.y == 2)
-    {
-      ret.push_back({ t.level + 1, 0, 0 });
-      ret.push_back({ t.level + 1, 0, 1 });
-      ret.push_back({ t.level + 1, 0, 2 });
-      ret.push_back({ t.level + 1, 0, 3 });
-      ret.push_back({ t.level + 1, 0, 4 });
-    }
-    else
-    {
-      ret.push_back({ t.level, t.x + 1, t.y });
-    }
-  }
-  else
-  {
-    ret.push_back({ t.level - 1, 3, 2 });
-  }
-
-  if (map::in_bounds(t.x - 1, t.y))
-  {
-    if (t.x - 1 == 2 && t.y == 2)
-    {
-      ret.push_back({ t.level + 1, 4, 0 });
-      ret.push_back({ t.level + 1, 4, 1 });
-      ret.push_back({ t.level + 1, 4, 2 });
-      ret.push_back({ t.level + 1, 4, 3 });
-      ret.push_back({ t.level + 1, 4, 4 });
-    }
-    else
-    {
-      ret.push_back({ t.level, t.x - 1, t.y });
-    }
-  }
-  else
-  {
-    ret.push_back({ t.level - 1, 1, 2 });
-  }
+  neighbour_counter counter;
+  add_neighbours_on_level(counter, bugs);
+
+  // Edge tiles see the tile next to the center of the level around.
+  counter.add((outer & above_center) != 0 ? row_0 : 0);
+  counter.add((outer & below_center) != 0 ? row_4 : 0);
+  counter.add((outer & left_of_center) != 0 ? column_0 : 0);
+  counter.add((outer & right_of_center) != 0 ? column_4 : 0);
+
+  // Tiles next to the center see a whole edge of the level inside.
+  counter.add(above_center, count_cells(inner & row_0));
+  counter.add(below_center, count_cells(inner & row_4));
+  counter.add(left_of_center, count_cells(inner & column_0));
+  counter.add(right_of_center, count_cells(inner & column_4));
+
+  return counter.next_generation(bugs) & ~center;
+}
 
-  if (map::in_bounds(t.x, t.y + 1))
-  {
-    if (t.x == 2 && t.y + 1 == 2)
-    {
-      ret.push_back({ t.level + 1, 0, 0 });
-      ret.push_back({ t.level + 1, 1, 0 });
-      ret.push_back({ t.level + 1, 2, 0 });
-      ret.push_back({ t.level + 1, 3, 0 });
-      ret.push_back({ t.level + 1, 4, 0 });
-    }
-    else
-    {
-      ret.push_back({ t.level, t.x, t.y + 1 });
-    }
-  }
-  else
+// One generation of 'current' into 'next', reusing its storage.
+// Bugs spread at most one level in or out per generation.
+void process_level_hierarchy(level_hierarchy const& current, level_hierarchy& next)
+{
+  next.outermost_level = current.outermost_level - 1;
+  next.levels.resize(current.levels.size() + 2);
+  for (int i = 0; i < (int)next.levels.size(); i++)
   {
-    ret.push_back({ t.level - 1, 2, 3 });
+    // Level i of 'next' is level i - 1 of 'current'.
+    next.levels[i] = process_recursive_level(current.at(i - 1), current.at(i - 2), current.at(i));
   }
 
-  if (map::in_bounds(t.x, t.y - 1))
+  // Drops the empty levels around the bugs.
+  while (!next.levels.empty() && next.levels.back() == 0)
   {
-    if (t.x == 2 && t.y - 1 == 2)
-    {
-      ret.push_back({ t.level + 1, 0, 4 });
-      ret.push_back({ t.level + 1, 1, 4 });
-      ret.push_back({ t.level + 1, 2, 4 });
-      ret.push_back({ t.level + 1, 3, 4 });
-      ret.push_back({ t.level + 1, 4, 4 });
-    }
-    else
-    {
-      ret.push_back({ t.level, t.x, t.y - 1 });
-    }
+    next.levels.pop_back();
   }
-  else
-  {
-    ret.push_back({ t.level - 1, 2, 1 });
-  }
-
-  return ret;
+  const auto first_with_bugs = std::find_if(next.levels.begin(), next.levels.end(), [](level l) { return l != 0; });
+  next.outermost_level += (int)(first_with_bugs - next.levels.begin());
+  next.levels.erase(next.levels.begin(), first_with_bugs);
 }
 
-map_hierarchy process_map_hierarchy(map_hierarchy const& mh)
+uint64_t count_bugs(level_hierarchy const& lh)
 {
-  map_hierarchy ret = mh;
-  for (int level = min_level; level <= max_level; level++)
+  uint64_t ret = 0;
+  for (level l : lh.levels)
   {
-    for (int y = 0; y < 5; y++)
-    {
-      for (int x = 0; x < 5; x++)
-      {
-        if (x == 2 && y == 2)
-        {
-          continue;
-        }
-        std::vector<tile> adj = adjacent_tiles({ level, x, y });
-        uint64_t adj_bugs = 0;
-        for (auto const& t : adj)
-        {
-          if (mh.at(t.level).at(t.x, t.y) == '#')
-          {
-            adj_bugs++;
-          }
-        }
-        if (mh.at(level).at(x, y) == '#')
-        {
-          ret.at(level).at(x, y) = (adj_bugs == 1) ? '#' : '.';
-        }
-        else if (mh.at(level).at(x, y) == '.')
-        {
-          ret.at(level).at(x, y) = (adj_bugs == 1 || adj_bugs == 2) ? '#' : '.';
-        }
-      }
-    }
+    ret += count_cells(l);
   }
-
   return ret;
 }
 
-uint64_t count_bugs_at_level(map const& m)
+level read_level(const char* input)
 {
-  uint64_t ret = 0;
-  for (int y = 0; y < 5; y++)
+  level ret = 0;
+  for (int y = 0; y < height; y++)
   {
-    for (int x = 0; x < 5; x++)
+    for (int x = 0; x < width; x++)
     {
-      if (m.at(x, y) == '#')
+      if (input[x + (width + 1) * y] == '#')
       {
-        ret++;
+        ret |= cell(x, y);
       }
     }
   }
   return ret;
 }
 
-uint64_t count_bugs(map_hierarchy const& mh)
-{
-  uint64_t ret = 0;
-  for (auto const& p : mh)
-  {
-    ret += count_bugs_at_level(p.second);
-  }
-  return ret;
-}
-
 } // namespace
 
-void solver<DAY, 1>::solve(const char* input, char* output)
+void solver<DAY, 1>::solve(const char* input, output_sink& output)
 {
-  std::unordered_set<uint64_t> hashes;
-
-  map m;
-  for (int y = 0; y < 5; y++)
-  {
-    for (int x = 0; x < 5; x++)
-    {
-      m.data[x + 5 * y] = input[x + 6 * y];
-    }
-  }
-  while (hashes.find(hash_map(m)) == hashes.end())
-  {
-    hashes.emplace(hash_map(m));
-    m = process_map(m);
-  }
-
-  output += sprintf(output, "%llu", hash_map(m));
+  const cycle_info<level> cycle = find_cycle(read_level(input), process_level);
+  // The bits of a level are its biodiversity rating.
+  output.print("%llu", (uint64_t)cycle.first_repeated);
 }
 
-void solver<DAY, 2>::solve(const char* input, char* output)
+void solver<DAY, 2>::solve(const char* input, output_sink& output)
 {
-  map_hierarchy mh;
-  mh[0] = {};
-  for (int y = 0; y < 5; y++)
-  {
-    for (int x = 0; x < 5; x++)
-    {
-      mh.at(0).at(x, y) = input[x + 6 * y];
-    }
-  }
-  for (int i = 1; i <= max_level + 1; i++)
-  {
-    mh[i] = {};
-    mh.at(i).at(2, 2) = '?';
-  }
-  for (int i = -1; i >= min_level - 1; i--)
-  {
-    mh[i] = {};
-    mh.at(i).at(2, 2) = '?';
-  }
+  level_hierarchy current;
+  level_hierarchy next;
+  // The center is the level inside, never a bug.
+  current.levels.push_back(read_level(input) & ~center);
 
   for (int i = 0; i < 200; i++)
   {
-    mh = process_map_hierarchy(mh);
+    process_level_hierarchy(current, next);
+    std::swap(current, next);
   }
-  output += sprintf(output, "%llu", count_bugs(mh));
+  output.print("%llu", count_bugs(current));
 }
@@ -13,9 +13,9 @@ namespace
 // Put solution helpers here
 } // namespace
 
-void solver<DAY, 1>::solve(const char* input, char* output)
+void solver<DAY, 1>::solve(const char* input, output_sink& output)
 {
-  intcode_program program = read_intcode_program(input);
+  intcode_program program = load_intcode_program(input);
   intcode_machine machine{ program };
   char buffer[16 * 1024];
   uint32_t inventory_state = 0;
@@ -123,6 +123,6 @@ void solver<DAY, 1>::solve(const char* input, char* output)
   }
 }
 
-void solver<DAY, 2>::solve(const char* input, char* output)
+void solver<DAY, 2>::solve(const char* input, output_sink& output)
 {
 }
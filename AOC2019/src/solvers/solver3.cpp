@@ -180,7 +180,7 @@ std::vector<vec2> read_wire(const char* s)
 
 } // namespace
 
-void solver<DAY, 1>::solve(const char* input, char* output)
+void solver<DAY, 1>::solve(const char* input, output_sink& output)
 {
   std::vector<vec2> wire_a = read_wire(input);
   while (*input != '\n') input++;
@@ -201,10 +201,10 @@ void solver<DAY, 1>::solve(const char* input, char* output)
     }
   }
 
-  sprintf(output, "%d", best_dist);
+  output.print("%d", best_dist);
 }
 
-void solver<DAY, 2>::solve(const char* input, char* output)
+void solver<DAY, 2>::solve(const char* input, output_sink& output)
 {
   std::vector<vec2> wire_a = read_wire(input);
   while (*input != '\n') input++;
@@ -231,5 +231,5 @@ void solver<DAY, 2>::solve(const char* input, char* output)
     wire_a_steps += dist_l1(wire_a[i], wire_a[i + 1]);
   }
 
-  sprintf(output, "%d", best_steps);
+  output.print("%d", best_steps);
 }
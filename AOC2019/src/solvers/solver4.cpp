@@ -84,10 +84,8 @@ static bool is_password_2(int x)
 
 } // namespace
 
-void solver<DAY, 1>::solve(const char* input, char* output)
+void solver<DAY, 1>::solve(const char* input, output_sink& output)
 {
-  output[0] = 0;
-
   int range_min;
   int range_max;
   sscanf(input, "%d-%d", &range_min, &range_max);
@@ -101,13 +99,11 @@ void solver<DAY, 1>::solve(const char* input, char* output)
     }
   }
 
-  sprintf(output, "%d", num_passwords);
+  output.print("%d", num_passwords);
 }
 
-void solver<DAY, 2>::solve(const char* input, char* output)
+void solver<DAY, 2>::solve(const char* input, output_sink& output)
 {
-  output[0] = 0;
-
   int range_min;
   int range_max;
   sscanf(input, "%d-%d", &range_min, &range_max);
@@ -121,5 +117,5 @@ void solver<DAY, 2>::solve(const char* input, char* output)
     }
   }
 
-  sprintf(output, "%d", num_passwords);
+  output.print("%d", num_passwords);
 }
\ No newline at end of file
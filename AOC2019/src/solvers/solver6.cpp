@@ -43,7 +43,7 @@ struct planet_hasher
 // COM - root
 
 }
-void solver<DAY, 1>::solve(const char* input, char* output)
+void solver<DAY, 1>::solve(const char* input, output_sink& output)
 {
   std::vector<planet> planets;
   std::unordered_map<planet, uint64_t, planet_hasher> map_planets_to_id;
@@ -112,10 +112,10 @@ void solver<DAY, 1>::solve(const char* input, char* output)
     }
   }
 
-  sprintf(output, "%llu", orbit_count);
+  output.print("%llu", orbit_count);
 }
 
-void solver<DAY, 2>::solve(const char* input, char* output)
+void solver<DAY, 2>::solve(const char* input, output_sink& output)
 {
   std::vector<planet> planets;
   std::unordered_map<planet, uint64_t, planet_hasher> map_planets_to_id;
@@ -198,5 +198,5 @@ void solver<DAY, 2>::solve(const char* input, char* output)
     transfer_count = (you_path.size() - lca_height - 1) + (san_path.size() - lca_height - 1);
   }
 
-  sprintf(output, "%llu", transfer_count);
+  output.print("%llu", transfer_count);
 }
@@ -114,7 +114,7 @@ image_layer flatten_image(image const& img)
 
 }
 
-void solver<DAY, 1>::solve(const char* input, char* output)
+void solver<DAY, 1>::solve(const char* input, output_sink& output)
 {
   using namespace task_1;
 
@@ -131,22 +131,17 @@ void solver<DAY, 1>::solve(const char* input, char* output)
     }
   }
   int ret = img[best_layer].num_digits('1') * img[best_layer].num_digits('2');
-  sprintf(output, "%d", ret);
+  output.print("%d", ret);
 }
 
-void solver<DAY, 2>::solve(const char* input, char* output)
+void solver<DAY, 2>::solve(const char* input, output_sink& output)
 {
-  output[0] = 0;
-
   using namespace task_2;
   image img = read_image(input);
   image_layer flattened_img = flatten_image(img);
   for (int r = 0; r < 6; r++)
   {
-    memcpy(output, flattened_img.pixels[r], 25);
-    output += 25;
-    *output = '\n';
-    output++;
+    output.append(flattened_img.pixels[r], 25);
+    output.put('\n');
   }
-  *output = 0;
 }